@@ -0,0 +1,113 @@
+#include "arena.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef union {
+    long double number;
+    long long integer;
+    void *pointer;
+    void (*function)(void);
+} MaxAlign;
+
+#define ARENA_ALIGNMENT sizeof(MaxAlign)
+
+struct arena_chunk {
+    struct arena_chunk *next;
+    size_t used;
+    size_t size;
+    MaxAlign data[];
+};
+
+void arena_init(Arena *arena, size_t chunk_size) {
+    assert(arena != NULL);
+
+    arena->head = NULL;
+    arena->chunk_size = chunk_size;
+}
+
+void *arena_alloc(Arena *arena, size_t size) {
+    assert(arena != NULL);
+
+    size = (size + ARENA_ALIGNMENT - 1) / ARENA_ALIGNMENT * ARENA_ALIGNMENT;
+
+    struct arena_chunk *chunk = arena->head;
+    if (chunk == NULL || chunk->size - chunk->used < size) {
+        size_t chunk_size = size > arena->chunk_size ? size : arena->chunk_size;
+
+        chunk = malloc(sizeof(struct arena_chunk) + chunk_size);
+        if (chunk == NULL) {
+            return NULL;
+        }
+        chunk->used = 0;
+        chunk->size = chunk_size;
+
+        // An oversized chunk is full right away, keep filling the current one.
+        if (arena->head != NULL && chunk_size > arena->chunk_size) {
+            chunk->next = arena->head->next;
+            arena->head->next = chunk;
+        } else {
+            chunk->next = arena->head;
+            arena->head = chunk;
+        }
+    }
+
+    void *memory = (char *) chunk->data + chunk->used;
+    chunk->used += size;
+
+    return memory;
+}
+
+char *arena_strndup(Arena *arena, const char *str, size_t length) {
+    assert(str != NULL);
+
+    char *copy = arena_alloc(arena, length + 1);
+    if (copy == NULL) {
+        return NULL;
+    }
+
+    memcpy(copy, str, length);
+    copy[length] = '\0';
+
+    return copy;
+}
+
+void arena_reset(Arena *arena) {
+    assert(arena != NULL);
+
+    struct arena_chunk *head = arena->head;
+    if (head == NULL || head->next == NULL) {
+        if (head != NULL) {
+            head->used = 0;
+        }
+        return;
+    }
+
+    size_t total = 0;
+    for (struct arena_chunk *chunk = head; chunk != NULL; chunk = chunk->next) {
+        total += chunk->size;
+    }
+    arena_free(arena);
+
+    struct arena_chunk *chunk = malloc(sizeof(struct arena_chunk) + total);
+    if (chunk != NULL) {
+        chunk->next = NULL;
+        chunk->used = 0;
+        chunk->size = total;
+        arena->head = chunk;
+    }
+}
+
+void arena_free(Arena *arena) {
+    assert(arena != NULL);
+
+    struct arena_chunk *chunk = arena->head;
+    while (chunk != NULL) {
+        struct arena_chunk *next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+
+    arena->head = NULL;
+}
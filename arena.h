@@ -0,0 +1,31 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+struct arena_chunk;
+
+// Bump allocator: memory is handed out from large chunks and released all at once.
+typedef struct Arena {
+    struct arena_chunk *head;
+    size_t chunk_size;
+} Arena;
+
+// Prepares an empty arena that allocates chunks of at least chunk_size bytes.
+void arena_init(Arena *arena, size_t chunk_size);
+
+// Returns size bytes aligned for any object type, or NULL on allocation failure.
+void *arena_alloc(Arena *arena, size_t size);
+
+// Copies length bytes of str into the arena and appends '\0'.
+char *arena_strndup(Arena *arena, const char *str, size_t length);
+
+// Releases everything allocated from the arena but keeps its memory: the chunks are
+// replaced by a single one as large as all of them, so allocating as much again
+// takes no further chunk. Allocation failure leaves the arena empty.
+void arena_reset(Arena *arena);
+
+// Frees every chunk of the arena, the arena can be used again afterwards.
+void arena_free(Arena *arena);
+
+#endif // ARENA_H
@@ -0,0 +1,135 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "batch.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include "arena.h"
+#include "data_source.h"
+#include "parse_args.h"
+
+#define BATCH_SPACES " \t\r\n"
+
+// Returns the next word of the line and terminates it in place, NULL at the end of the line.
+static char *next_word(char **cursor) {
+    char *word = *cursor + strspn(*cursor, BATCH_SPACES);
+    if (*word == '\0') {
+        *cursor = word;
+        return NULL;
+    }
+
+    char *end = word + strcspn(word, BATCH_SPACES);
+    *cursor = *end != '\0' ? end + 1 : end;
+    *end = '\0';
+    return word;
+}
+
+// Applies the options left on the line, only the letters in allowed are accepted. A value
+// follows its letter either directly, as in -tPA, or as the next word.
+static bool parse_command_options(char **cursor, const char *allowed, Filters *filters) {
+    char *word;
+    while ((word = next_word(cursor)) != NULL) {
+        if (word[0] != '-' || word[1] == '\0' || strchr(allowed, word[1]) == NULL) {
+            fprintf(stderr, "Unexpected argument '%s'\n", word);
+            return false;
+        }
+        const char *value = word[2] != '\0' ? word + 2 : next_word(cursor);
+        if (value == NULL) {
+            fprintf(stderr, "Option -%c needs a value\n", word[1]);
+            return false;
+        }
+        if (!parse_option(word[1], value, filters)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+ * Runs one command line. Everything built for a query, such as the
+ * contraction hierarchy or the landmarks, stays in the data source, so only
+ * the first command that needs it pays for it. Route searches take their
+ * memory from the scratch arena.
+ */
+static bool run_command(DataSource *source, char *line, Arena *scratch, FILE *output) {
+    char *cursor = line;
+    const char *command = next_word(&cursor);
+    Filters filters = default_filters();
+
+    if (strcmp(command, "filter") == 0) {
+        if (!parse_command_options(&cursor, "tcp", &filters)) {
+            return false;
+        }
+        if (!data_source_print_containers(source, filters, output)) {
+            fprintf(stderr, "Failed to list the containers\n");
+            return false;
+        }
+    } else if (strcmp(command, "stations") == 0) {
+        if (!parse_command_options(&cursor, "", &filters)) {
+            return false;
+        }
+        if (!data_source_print_stations(source, output)) {
+            fprintf(stderr, "Failed to list the stations\n");
+            return false;
+        }
+    } else if (strcmp(command, "route") == 0) {
+        const char *stations = next_word(&cursor);
+        if (stations == NULL || !parse_option('g', stations, &filters)
+            || !parse_command_options(&cursor, "aq", &filters)) {
+            return false;
+        }
+        filters.route_options.scratch = scratch;
+
+        size_t station_count = data_source_station_table(source)->count;
+        if (filters.route_from > station_count || filters.route_to > station_count) {
+            fprintf(stderr, "Station ID out of range, there are %zu stations\n", station_count);
+            return false;
+        }
+        if (!data_source_print_route(source, filters.route_from, filters.route_to, &filters.route_options, output)) {
+            fprintf(stderr, "Failed to find the route\n");
+            return false;
+        }
+    } else {
+        fprintf(stderr, "Unknown command '%s'. Use filter, stations or route.\n", command);
+        return false;
+    }
+    return true;
+}
+
+bool run_batch(DataSource *source, FILE *input, FILE *output, Arena *scratch) {
+    char *line = NULL;
+    size_t size = 0;
+    size_t line_number = 0;
+    bool ok = true;
+
+    while (getline(&line, &size, input) != -1) {
+        line_number++;
+        const char *start = line + strspn(line, BATCH_SPACES);
+        if (*start == '\0' || *start == '#') {
+            continue;
+        }
+
+        // Every command sees one snapshot of the data, a reload only affects the commands after it.
+        data_source_pin(source);
+        bool command_ok = run_command(source, line, scratch, output);
+        data_source_unpin(source);
+        if (scratch != NULL) {
+            arena_reset(scratch);
+        }
+        if (!command_ok) {
+            fprintf(stderr, "Error on line %zu of the commands\n", line_number);
+            fprintf(output, "Error: line %zu\n", line_number);
+            ok = false;
+        }
+        // Results are flushed one by one, so a client driving the batch through a pipe can read them.
+        fprintf(output, "\n");
+        if (fflush(output) == EOF) {
+            ok = false;
+            break;
+        }
+    }
+
+    ok = ok && !ferror(input);
+    free(line);
+    return ok;
+}
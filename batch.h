@@ -0,0 +1,21 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <stdbool.h>
+#include <stdio.h>
+#include "arena.h"
+#include "data_source.h"
+
+// Runs the commands read line by line from the input against the data source and
+// writes their results to the output:
+//   filter [-t waste_types] [-c min-max] [-p Y|N]
+//   stations
+//   route from,to [-a algorithm] [-q queue]
+// Empty lines and lines starting with '#' are skipped. The output of every command is
+// followed by an empty line, an invalid command writes "Error: line N" instead and its
+// reason to stderr. Route searches take their memory from the scratch arena, which is reset
+// after every command, or from the heap if it is NULL. Returns false if a command failed, the
+// input cannot be read or the output written.
+bool run_batch(DataSource *source, FILE *input, FILE *output, Arena *scratch);
+
+#endif // BATCH_H
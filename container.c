@@ -1,8 +1,29 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include "container.h"
+#include <ctype.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+// Column order of the containers file
+enum container_column {
+    COLUMN_ID,
+    COLUMN_X,
+    COLUMN_Y,
+    COLUMN_WASTE_TYPE,
+    COLUMN_CAPACITY,
+    COLUMN_NAME,
+    COLUMN_STREET,
+    COLUMN_NUMBER,
+    COLUMN_PUBLIC,
+};
+
+// Digits of the integer part of a coordinate that still fit its fixed-point key
+#define COORDINATE_INTEGER_DIGITS 4
+#define COORDINATE_SCALE 100000000000000LL
+
+
 Container *create_container(const char *id, float x, float y, const char *waste_type, float capacity, const char *name,
                             const char *street, const char *number, bool is_public) {
     Container *container = (Container *) malloc(sizeof(Container));
@@ -68,3 +89,193 @@ void print_container(const Container *container) {
 
     printf("Is Public: %s\n", container->is_public ? "Yes" : "No");
 }
+
+bool parse_unsigned(const char *text, uint64_t max, uint64_t *value) {
+    if (!isdigit((unsigned char) text[0])) {
+        return false;
+    }
+
+    uint64_t result = 0;
+    for (; *text != '\0'; text++) {
+        if (!isdigit((unsigned char) *text)) {
+            return false;
+        }
+        unsigned digit = *text - '0';
+        if (result > (max - digit) / 10) {
+            return false;
+        }
+        result = result * 10 + digit;
+    }
+
+    *value = result;
+    return true;
+}
+
+/*
+ * Parses a decimal coordinate such as "-16.607283420000044". Besides the
+ * value, it computes the key of the coordinate: the number truncated to
+ * COORDINATE_DECIMALS decimal places as a fixed-point integer, so equal
+ * keys mean coordinates equal to that precision without rounding errors.
+ * The value is skipped when it is NULL.
+ */
+static bool parse_coordinate(const char *text, double *value, int64_t *key) {
+    const char *digits = text[0] == '-' || text[0] == '+' ? text + 1 : text;
+    const char *point = digits;
+    int64_t integer_part = 0;
+
+    while (isdigit((unsigned char) *point)) {
+        if (point - digits == COORDINATE_INTEGER_DIGITS) {
+            return false;
+        }
+        integer_part = integer_part * 10 + (*point - '0');
+        point++;
+    }
+    if (point == digits || (*point != '.' && *point != '\0')) {
+        return false;
+    }
+
+    int64_t fraction = 0;
+    int decimals = 0;
+    if (*point == '.') {
+        for (const char *digit = point + 1; *digit != '\0'; digit++) {
+            if (!isdigit((unsigned char) *digit)) {
+                return false;
+            }
+            if (decimals < COORDINATE_DECIMALS) {
+                fraction = fraction * 10 + (*digit - '0');
+                decimals++;
+            }
+        }
+    }
+    for (; decimals < COORDINATE_DECIMALS; decimals++) {
+        fraction *= 10;
+    }
+
+    *key = integer_part * COORDINATE_SCALE + fraction;
+    if (text[0] == '-') {
+        *key = -*key;
+    }
+    if (value != NULL) {
+        *value = strtod(text, NULL);
+    }
+
+    return true;
+}
+
+bool container_table_init(ContainerTable *table, size_t count) {
+    table->count = count;
+    table->id = malloc(count * sizeof(uint64_t) + 1);
+    table->x = malloc(count * sizeof(double) + 1);
+    table->y = malloc(count * sizeof(double) + 1);
+    table->x_key = malloc(count * sizeof(int64_t) + 1);
+    table->y_key = malloc(count * sizeof(int64_t) + 1);
+    table->capacity = malloc(count * sizeof(uint32_t) + 1);
+    table->waste_type = malloc(count * sizeof(uint8_t) + 1);
+    table->is_public = malloc(count * sizeof(bool) + 1);
+    table->name = malloc(count * sizeof(uint32_t) + 1);
+    table->street = malloc(count * sizeof(uint32_t) + 1);
+    table->number = malloc(count * sizeof(uint32_t) + 1);
+    string_pool_init(&table->strings);
+
+    if (table->id == NULL || table->x == NULL || table->y == NULL
+        || table->x_key == NULL || table->y_key == NULL || table->capacity == NULL
+        || table->waste_type == NULL || table->is_public == NULL || table->name == NULL
+        || table->street == NULL || table->number == NULL) {
+        container_table_destroy(table);
+        return false;
+    }
+
+    return true;
+}
+
+bool container_table_set(ContainerTable *table, size_t index, const char *const *fields) {
+    return container_table_set_columns(table, index, fields, CONTAINER_COLUMNS_ALL);
+}
+
+/*
+ * Every field is checked whether its column is converted or not. Leaving a
+ * column out saves storing it, and for coordinates also strtod(), which is
+ * the slowest part of a row.
+ */
+bool container_table_set_columns(ContainerTable *table, size_t index, const char *const *fields,
+                                 ContainerColumns columns) {
+    uint64_t value;
+    WasteType waste_type;
+    int64_t key;
+
+    if (!parse_unsigned(fields[COLUMN_ID], UINT64_MAX, &table->id[index])) {
+        return false;
+    }
+    if ((columns & CONTAINER_COLUMN_X) != 0
+        ? !parse_coordinate(fields[COLUMN_X], &table->x[index], &table->x_key[index])
+        : !parse_coordinate(fields[COLUMN_X], NULL, &key)) {
+        return false;
+    }
+    if ((columns & CONTAINER_COLUMN_Y) != 0
+        ? !parse_coordinate(fields[COLUMN_Y], &table->y[index], &table->y_key[index])
+        : !parse_coordinate(fields[COLUMN_Y], NULL, &key)) {
+        return false;
+    }
+
+    if (!waste_type_parse(fields[COLUMN_WASTE_TYPE], &waste_type)) {
+        return false;
+    }
+    table->waste_type[index] = (uint8_t) waste_type;
+
+    if (!parse_unsigned(fields[COLUMN_CAPACITY], UINT32_MAX, &value)) {
+        return false;
+    }
+    table->capacity[index] = (uint32_t) value;
+
+    if (fields[COLUMN_NUMBER][0] == '\0') {
+        table->number[index] = CONTAINER_NO_NUMBER;
+    } else if (parse_unsigned(fields[COLUMN_NUMBER], CONTAINER_NO_NUMBER - 1, &value)) {
+        table->number[index] = (uint32_t) value;
+    } else {
+        return false;
+    }
+
+    const char *public = fields[COLUMN_PUBLIC];
+    if ((public[0] != 'Y' && public[0] != 'N') || public[1] != '\0') {
+        return false;
+    }
+    table->is_public[index] = public[0] == 'Y';
+
+    table->name[index] = CONTAINER_NO_STRING;
+    table->street[index] = CONTAINER_NO_STRING;
+    return container_table_set_strings(table, index, fields, columns);
+}
+
+bool container_table_set_strings(ContainerTable *table, size_t index, const char *const *fields,
+                                 ContainerColumns columns) {
+    if ((columns & CONTAINER_COLUMN_NAME) != 0) {
+        table->name[index] = string_pool_intern(&table->strings, fields[COLUMN_NAME]);
+        if (table->name[index] == STRING_POOL_ERROR) {
+            return false;
+        }
+    }
+    if ((columns & CONTAINER_COLUMN_STREET) != 0) {
+        table->street[index] = string_pool_intern(&table->strings, fields[COLUMN_STREET]);
+        if (table->street[index] == STRING_POOL_ERROR) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void container_table_destroy(ContainerTable *table) {
+    free(table->id);
+    free(table->x);
+    free(table->y);
+    free(table->x_key);
+    free(table->y_key);
+    free(table->capacity);
+    free(table->waste_type);
+    free(table->is_public);
+    free(table->name);
+    free(table->street);
+    free(table->number);
+    string_pool_destroy(&table->strings);
+    memset(table, 0, sizeof(*table));
+}
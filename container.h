@@ -2,6 +2,10 @@
 #define CONTAINER_H
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "string_pool.h"
+#include "waste_type.h"
 
 typedef struct Container {
     char *id;
@@ -25,4 +29,70 @@ void destroy_container(Container *container);
 // Prints the information of a Container.
 void print_container(const Container *container);
 
+// Number of decimal places to which coordinates of containers of one station are equal.
+#define COORDINATE_DECIMALS 14
+
+// Marks a container without a house number.
+#define CONTAINER_NO_NUMBER UINT32_MAX
+
+// Marks a name or street that was not stored, see container_table_set_columns().
+#define CONTAINER_NO_STRING STRING_POOL_ERROR
+
+// Set of columns of the containers file, one bit per column in the order of the file.
+typedef uint16_t ContainerColumns;
+
+#define CONTAINER_COLUMN_ID ((ContainerColumns) (1u << 0))
+#define CONTAINER_COLUMN_X ((ContainerColumns) (1u << 1))
+#define CONTAINER_COLUMN_Y ((ContainerColumns) (1u << 2))
+#define CONTAINER_COLUMN_WASTE_TYPE ((ContainerColumns) (1u << 3))
+#define CONTAINER_COLUMN_CAPACITY ((ContainerColumns) (1u << 4))
+#define CONTAINER_COLUMN_NAME ((ContainerColumns) (1u << 5))
+#define CONTAINER_COLUMN_STREET ((ContainerColumns) (1u << 6))
+#define CONTAINER_COLUMN_NUMBER ((ContainerColumns) (1u << 7))
+#define CONTAINER_COLUMN_PUBLIC ((ContainerColumns) (1u << 8))
+#define CONTAINER_COLUMNS_ALL ((ContainerColumns) ((1u << 9) - 1))
+
+// Containers stored column by column, converted from text once when loaded.
+// Coordinate keys are the coordinates truncated to COORDINATE_DECIMALS decimal places
+// as fixed-point integers. Names and streets are IDs of interned strings in the strings pool.
+typedef struct ContainerTable {
+    size_t count;
+    uint64_t *id;
+    double *x;
+    double *y;
+    int64_t *x_key;
+    int64_t *y_key;
+    uint32_t *capacity;
+    uint8_t *waste_type;
+    bool *is_public;
+    uint32_t *name;
+    uint32_t *street;
+    uint32_t *number;
+    StringPool strings;
+} ContainerTable;
+
+// Allocates the columns for count containers. Returns false on allocation failure.
+bool container_table_init(ContainerTable *table, size_t count);
+
+// Converts and validates one row of the containers file and stores it at index.
+// Returns false if any of the fields is invalid or on allocation failure.
+bool container_table_set(ContainerTable *table, size_t index, const char *const *fields);
+
+// Same as container_table_set(), but only the columns in the mask are stored. The
+// coordinates of the others are left unset, their name and street are CONTAINER_NO_STRING.
+// Every field is still validated, the ID and the small columns are always stored.
+bool container_table_set_columns(ContainerTable *table, size_t index, const char *const *fields,
+                                 ContainerColumns columns);
+
+// Interns the name and street of the row if they are in the mask, for a row stored without
+// them by container_table_set_columns(). Returns false on allocation failure.
+bool container_table_set_strings(ContainerTable *table, size_t index, const char *const *fields,
+                                 ContainerColumns columns);
+
+// Frees the columns of the table.
+void container_table_destroy(ContainerTable *table);
+
+// Parses a non-negative decimal integer of at most max, without sign or spaces.
+bool parse_unsigned(const char *text, uint64_t max, uint64_t *value);
+
 #endif // CONTAINER_H
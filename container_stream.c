@@ -0,0 +1,252 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "container_stream.h"
+
+#include <assert.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include "container.h"
+#include "path.h"
+
+#define CONTAINER_COLUMNS_COUNT 9
+#define PATH_COLUMNS_COUNT 3
+
+// Columns of a listed container, its street only when it passes the filters.
+#define STREAM_COLUMNS (CONTAINER_COLUMN_ID | CONTAINER_COLUMN_WASTE_TYPE | CONTAINER_COLUMN_CAPACITY \
+                        | CONTAINER_COLUMN_NUMBER | CONTAINER_COLUMN_PUBLIC)
+
+// Bytes of interned names and streets after which the table of the current row starts
+// over, so the strings of rows printed long ago do not pile up.
+#define STREAM_STRINGS_LIMIT (1024 * 1024)
+
+// One direction of a path. A path from a container to itself is kept as a pair of
+// equal IDs, so its container is still looked for, but it is never printed.
+struct neighbor_pair {
+    uint64_t id;
+    uint64_t neighbor;
+};
+
+// Neighbors of the containers sorted by the ID and then by the neighbor, without repeats.
+struct adjacency {
+    struct neighbor_pair *pairs;
+    size_t count;
+    size_t capacity;
+
+    // Set for the first pair of a container once the container was read.
+    bool *seen;
+};
+
+static FILE *open_input(const char *path) {
+    return strcmp(path, CONTAINER_STREAM_STDIN) == 0 ? stdin : fopen(path, "r");
+}
+
+static void close_input(FILE *input) {
+    if (input != stdin) {
+        fclose(input);
+    }
+}
+
+/*
+ * Splits a line read by getline() into column_count fields in place, with
+ * the same rules as the loader of whole files: exactly column_count fields,
+ * the first and the last of them not empty.
+ */
+static bool split_row(char *line, size_t length, int column_count, char **fields) {
+    if (length > 0 && line[length - 1] == '\n') {
+        line[--length] = '\0';
+    }
+
+    int columns = 0;
+    char *field = line;
+    for (char *comma; (comma = strchr(field, ',')) != NULL; field = comma + 1) {
+        if (columns == column_count - 1) {
+            return false;
+        }
+        *comma = '\0';
+        fields[columns++] = field;
+    }
+    fields[columns++] = field;
+
+    return columns == column_count && fields[0][0] != '\0' && fields[column_count - 1][0] != '\0';
+}
+
+static bool add_pair(struct adjacency *adjacency, uint64_t id, uint64_t neighbor) {
+    if (adjacency->count == adjacency->capacity) {
+        size_t capacity = adjacency->capacity * 2 + 1024;
+        struct neighbor_pair *pairs = realloc(adjacency->pairs, capacity * sizeof(struct neighbor_pair));
+        if (pairs == NULL) {
+            return false;
+        }
+        adjacency->pairs = pairs;
+        adjacency->capacity = capacity;
+    }
+
+    adjacency->pairs[adjacency->count].id = id;
+    adjacency->pairs[adjacency->count].neighbor = neighbor;
+    adjacency->count++;
+    return true;
+}
+
+static int compare_pairs(const void *a, const void *b) {
+    const struct neighbor_pair *pair_a = a;
+    const struct neighbor_pair *pair_b = b;
+    if (pair_a->id != pair_b->id) {
+        return (pair_a->id > pair_b->id) - (pair_a->id < pair_b->id);
+    }
+    return (pair_a->neighbor > pair_b->neighbor) - (pair_a->neighbor < pair_b->neighbor);
+}
+
+// Reads both directions of every path, then sorts them and drops the repeated ones.
+static bool read_adjacency(const char *paths_path, struct adjacency *adjacency) {
+    FILE *input = open_input(paths_path);
+    if (input == NULL) {
+        return false;
+    }
+    PathTable row;
+    if (!path_table_init(&row, 1)) {
+        close_input(input);
+        return false;
+    }
+
+    char *line = NULL;
+    size_t line_capacity = 0;
+    ssize_t length;
+    bool ok = true;
+    while (ok && (length = getline(&line, &line_capacity, input)) != -1) {
+        char *fields[PATH_COLUMNS_COUNT];
+        ok = split_row(line, (size_t) length, PATH_COLUMNS_COUNT, fields)
+             && path_table_set(&row, 0, (const char *const *) fields)
+             && add_pair(adjacency, row.a_id[0], row.b_id[0])
+             && (row.a_id[0] == row.b_id[0] || add_pair(adjacency, row.b_id[0], row.a_id[0]));
+    }
+    ok = ok && !ferror(input);
+
+    free(line);
+    path_table_destroy(&row);
+    close_input(input);
+    if (!ok) {
+        return false;
+    }
+
+    qsort(adjacency->pairs, adjacency->count, sizeof(struct neighbor_pair), compare_pairs);
+    size_t kept = 0;
+    for (size_t index = 0; index < adjacency->count; index++) {
+        if (kept == 0 || compare_pairs(&adjacency->pairs[kept - 1], &adjacency->pairs[index]) != 0) {
+            adjacency->pairs[kept++] = adjacency->pairs[index];
+        }
+    }
+    adjacency->count = kept;
+
+    adjacency->seen = calloc(kept + 1, sizeof(bool));
+    return adjacency->seen != NULL;
+}
+
+// Returns the first pair of the container, or the count of pairs if it has none.
+static size_t find_neighbors(const struct adjacency *adjacency, uint64_t id) {
+    size_t low = 0;
+    size_t high = adjacency->count;
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (adjacency->pairs[middle].id < id) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low < adjacency->count && adjacency->pairs[low].id == id ? low : adjacency->count;
+}
+
+static void print_neighbors(const struct adjacency *adjacency, size_t first, FILE *output) {
+    bool printed = false;
+    for (size_t index = first; index < adjacency->count && adjacency->pairs[index].id == adjacency->pairs[first].id;
+         index++) {
+        if (adjacency->pairs[index].neighbor != adjacency->pairs[index].id) {
+            fprintf(output, printed ? " %" PRIu64 : "%" PRIu64, adjacency->pairs[index].neighbor);
+            printed = true;
+        }
+    }
+}
+
+/*
+ * Every row is converted into a table of a single row, which is recycled
+ * for the next one. Only the rows passing the filters get their strings.
+ * A container listed twice is only noticed when it has neighbors, as those
+ * are the only IDs kept.
+ */
+static bool stream_rows(FILE *input, struct adjacency *adjacency, Filters filters, FILE *output) {
+    ContainerTable row;
+    if (!container_table_init(&row, 1)) {
+        return false;
+    }
+
+    char *line = NULL;
+    size_t line_capacity = 0;
+    ssize_t length;
+    bool ok = true;
+    while (ok && (length = getline(&line, &line_capacity, input)) != -1) {
+        char *fields[CONTAINER_COLUMNS_COUNT];
+        if (!split_row(line, (size_t) length, CONTAINER_COLUMNS_COUNT, fields)
+            || !container_table_set_columns(&row, 0, (const char *const *) fields, STREAM_COLUMNS)) {
+            ok = false;
+            break;
+        }
+
+        size_t first = find_neighbors(adjacency, row.id[0]);
+        if (first < adjacency->count) {
+            if (adjacency->seen[first]) {
+                ok = false;
+                break;
+            }
+            adjacency->seen[first] = true;
+        }
+
+        if (container_matches_filters(&row, 0, filters)) {
+            if (!container_table_set_strings(&row, 0, (const char *const *) fields, CONTAINER_COLUMN_STREET)) {
+                ok = false;
+                break;
+            }
+            print_container_fields(&row, 0, string_pool_get(&row.strings, row.street[0]), output);
+            if (first < adjacency->count) {
+                print_neighbors(adjacency, first, output);
+            }
+            fprintf(output, "\n");
+        }
+
+        if (row.strings.size > STREAM_STRINGS_LIMIT) {
+            container_table_destroy(&row);
+            ok = container_table_init(&row, 1);
+        }
+    }
+    ok = ok && !ferror(input);
+
+    free(line);
+    container_table_destroy(&row);
+    return ok;
+}
+
+bool stream_containers(const char *containers_path, const char *paths_path, Filters filters, FILE *output) {
+    assert(containers_path != NULL && paths_path != NULL && output != NULL);
+
+    struct adjacency adjacency = { NULL, 0, 0, NULL };
+    if (!read_adjacency(paths_path, &adjacency)) {
+        free(adjacency.pairs);
+        free(adjacency.seen);
+        return false;
+    }
+
+    FILE *input = open_input(containers_path);
+    bool ok = input != NULL && stream_rows(input, &adjacency, filters, output);
+    if (input != NULL) {
+        close_input(input);
+    }
+
+    // Every path has to end at containers of the file.
+    for (size_t index = 0; ok && index < adjacency.count; index++) {
+        ok = adjacency.seen[index] || (index > 0 && adjacency.pairs[index - 1].id == adjacency.pairs[index].id);
+    }
+
+    free(adjacency.pairs);
+    free(adjacency.seen);
+    return ok;
+}
@@ -0,0 +1,21 @@
+#ifndef CONTAINER_STREAM_H
+#define CONTAINER_STREAM_H
+
+#include <stdbool.h>
+#include <stdio.h>
+#include "data_source.h"
+
+// Path meaning the standard input, accepted for one of the two files.
+#define CONTAINER_STREAM_STDIN "-"
+
+// Prints the containers passing the filters the same way as print_containers(), but reads
+// the containers file row by row instead of loading it. Only the neighbors of every
+// container are kept in memory, built from the paths file before the containers are read.
+//
+// A row is checked when it is read, so an invalid containers file ends the listing with
+// false after the rows before it were printed. Paths to containers missing from the file
+// are reported the same way once all the rows were read. Returns false as well if a file
+// cannot be read or on allocation failure.
+bool stream_containers(const char *containers_path, const char *paths_path, Filters filters, FILE *output);
+
+#endif // CONTAINER_STREAM_H
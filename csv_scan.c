@@ -0,0 +1,131 @@
+#include "csv_scan.h"
+
+#include <assert.h>
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__)))
+#define CSV_SCAN_X86
+#include <immintrin.h>
+#endif
+
+#ifdef CSV_SCAN_X86
+static void classify_sse2(const char *block, uint64_t *commas, uint64_t *newlines) {
+    const __m128i comma = _mm_set1_epi8(',');
+    const __m128i newline = _mm_set1_epi8('\n');
+
+    *commas = 0;
+    *newlines = 0;
+
+    for (int index = 0; index < CSV_SCAN_BLOCK_SIZE / 16; index++) {
+        __m128i chunk = _mm_loadu_si128((const __m128i *) (block + 16 * index));
+        uint64_t comma_bits = (uint16_t) _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, comma));
+        uint64_t newline_bits = (uint16_t) _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newline));
+
+        *commas |= comma_bits << (16 * index);
+        *newlines |= newline_bits << (16 * index);
+    }
+}
+
+__attribute__((target("avx2")))
+static void classify_avx2(const char *block, uint64_t *commas, uint64_t *newlines) {
+    const __m256i comma = _mm256_set1_epi8(',');
+    const __m256i newline = _mm256_set1_epi8('\n');
+
+    __m256i low = _mm256_loadu_si256((const __m256i *) block);
+    __m256i high = _mm256_loadu_si256((const __m256i *) (block + 32));
+
+    *commas = (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(low, comma))
+              | (uint64_t) (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(high, comma)) << 32;
+    *newlines = (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(low, newline))
+                | (uint64_t) (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(high, newline)) << 32;
+}
+#else
+static void classify_scalar(const char *block, uint64_t *commas, uint64_t *newlines) {
+    *commas = 0;
+    *newlines = 0;
+
+    for (int index = 0; index < CSV_SCAN_BLOCK_SIZE; index++) {
+        *commas |= (uint64_t) (block[index] == ',') << index;
+        *newlines |= (uint64_t) (block[index] == '\n') << index;
+    }
+}
+#endif
+
+static CsvClassifier select_classifier(void) {
+#ifdef CSV_SCAN_X86
+    if (__builtin_cpu_supports("avx2")) {
+        return classify_avx2;
+    }
+    return classify_sse2;
+#else
+    return classify_scalar;
+#endif
+}
+
+// Classifies the block at offset, padding the last partial block with zeros.
+static void classify_block(CsvClassifier classify, const char *data, size_t size, size_t offset,
+                           uint64_t *commas, uint64_t *newlines) {
+    if (size - offset >= CSV_SCAN_BLOCK_SIZE) {
+        classify(data + offset, commas, newlines);
+        return;
+    }
+
+    char padded[CSV_SCAN_BLOCK_SIZE] = { 0 };
+    memcpy(padded, data + offset, size - offset);
+    classify(padded, commas, newlines);
+}
+
+void csv_scanner_init(CsvScanner *scanner, const char *data, size_t size) {
+    assert(scanner != NULL);
+    assert(data != NULL || size == 0);
+
+    scanner->data = data;
+    scanner->size = size;
+    scanner->block = 0;
+    scanner->structurals = 0;
+    scanner->classify = select_classifier();
+
+    if (size > 0) {
+        uint64_t commas;
+        uint64_t newlines;
+        classify_block(scanner->classify, data, size, 0, &commas, &newlines);
+        scanner->structurals = commas | newlines;
+    }
+}
+
+const char *csv_scanner_next(CsvScanner *scanner) {
+    assert(scanner != NULL);
+
+    while (scanner->structurals == 0) {
+        scanner->block += CSV_SCAN_BLOCK_SIZE;
+        if (scanner->block >= scanner->size) {
+            return NULL;
+        }
+
+        uint64_t commas;
+        uint64_t newlines;
+        classify_block(scanner->classify, scanner->data, scanner->size, scanner->block, &commas, &newlines);
+        scanner->structurals = commas | newlines;
+    }
+
+    int bit = __builtin_ctzll(scanner->structurals);
+    scanner->structurals &= scanner->structurals - 1;
+
+    return scanner->data + scanner->block + bit;
+}
+
+size_t csv_count_newlines(const char *data, size_t size) {
+    assert(data != NULL || size == 0);
+
+    CsvClassifier classify = select_classifier();
+    size_t count = 0;
+
+    for (size_t offset = 0; offset < size; offset += CSV_SCAN_BLOCK_SIZE) {
+        uint64_t commas;
+        uint64_t newlines;
+        classify_block(classify, data, size, offset, &commas, &newlines);
+        count += __builtin_popcountll(newlines);
+    }
+
+    return count;
+}
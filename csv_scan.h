@@ -0,0 +1,30 @@
+#ifndef CSV_SCAN_H
+#define CSV_SCAN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define CSV_SCAN_BLOCK_SIZE 64
+
+// Finds bit masks of ',' and '\n' in one CSV_SCAN_BLOCK_SIZE-byte block.
+typedef void (*CsvClassifier)(const char *block, uint64_t *commas, uint64_t *newlines);
+
+// Iterates over the structural characters (',' and '\n') of a buffer.
+typedef struct {
+    const char *data;
+    size_t size;
+    size_t block;
+    uint64_t structurals;
+    CsvClassifier classify;
+} CsvScanner;
+
+// Prepares a scanner over [data, data + size) using the best instruction set of the CPU.
+void csv_scanner_init(CsvScanner *scanner, const char *data, size_t size);
+
+// Returns a pointer to the next ',' or '\n', or NULL when the buffer is exhausted.
+const char *csv_scanner_next(CsvScanner *scanner);
+
+// Counts '\n' characters in [data, data + size).
+size_t csv_count_newlines(const char *data, size_t size);
+
+#endif // CSV_SCAN_H
@@ -1,3 +1,5 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include "data_source.h"
 
 #include <string.h>
@@ -5,8 +7,19 @@
 #include <stdlib.h>
 #include <assert.h>
 #include <unistd.h>
-#include <math.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "arena.h"
 #include "container.h"
+#include "csv_scan.h"
+#include "graph.h"
+#include "parallel.h"
+#include "path.h"
+#include "snapshot_file.h"
+#include "station.h"
 
 // Container CSV column header
 #define CONTAINER_COLUMNS_COUNT 9
@@ -28,494 +41,1489 @@
 #define PATH_B 1
 #define PATH_DISTANCE 2
 
-struct data_source {
-    char ***containers;
-    size_t containers_count;
+// Row tables and copied fields of a single file are carved from one arena.
+#define CSV_ARENA_CHUNK_SIZE (256 * 1024)
+
+// Block size used to read files that cannot be mapped.
+#define CSV_READ_CHUNK_SIZE (64 * 1024)
+
+// Smallest part of a file worth handing to a separate parsing thread.
+#define CSV_PARALLEL_CHUNK_SIZE (1024 * 1024)
+
+// Room for the name of the shared memory object, four 64-bit numbers in hex and a prefix.
+#define SHARED_NAME_SIZE 96
+
+// Number of landmarks guiding A* route searches, each costs 8 bytes per station.
+#define STATION_LANDMARK_COUNT 16
+
+struct csv_table {
+    char ***lines;
+    size_t count;
+    Arena arena;
+
+    // Contents of the file the fields point into. It is either a private
+    // mapping made by map_csv() or a heap buffer filled by read_csv().
+    char *text;
+    size_t text_size;
+    bool mapped;
 
-    char ***paths;
-    size_t paths_count;
+    // Fields of a table mapped from a snapshot file, used instead of lines.
+    const uint64_t *field_offsets;
+    const char *field_text;
+    size_t field_text_size;
+
+    // Offsets of the lines of a table loaded lazily, followed by the size of
+    // the text. Such a table splits a row on its first use, until then its
+    // entry of lines is NULL.
+    size_t *line_starts;
 };
 
-typedef struct {
-    const char *id;
-    double distance;
-} Neighbor;
+// Tells a file replaced or rewritten since it was loaded.
+struct file_version {
+    dev_t device;
+    ino_t inode;
+    off_t size;
+    time_t modified;
+};
 
-typedef struct {
-    size_t id;
-    char *waste_types;
-    size_t *neighbors;
-    size_t neighbors_count;
-} Station;
+struct data_snapshot {
+    struct csv_table containers;
+    struct csv_table paths;
+
+    ContainerTable container_table;
+    PathTable path_table;
+    IdIndex container_index;
+    Graph container_graph;
+    StationTable station_table;
+    ContractionHierarchy station_hierarchy;
+    bool station_hierarchy_built;
+    Landmarks station_landmarks;
+    bool station_landmarks_built;
+
+    // Index of the IDs at the starts of the lines of lazily loaded containers, built
+    // on the first lookup. Its rows are positions in indexed_lines.
+    IdIndex lazy_index;
+    size_t *indexed_lines;
+    bool lazy_index_built;
+    // Typed tables of lazily loaded files, built from all the rows on first use.
+    bool lazy_tables_built;
+    bool lazy_tables_failed;
+
+    // Snapshot file the tables point into, if they were not built from the CSV files.
+    SnapshotMapping mapping;
+    // Some columns or strings were left out by the options it was loaded with.
+    bool partial;
+
+    // Files the snapshot was loaded from, as they were right before loading.
+    struct file_version versions[2];
+    SnapshotSource sources[2];
+    bool sources_known;
+    unsigned long version;
+    // Published snapshot counts once, every thread that pinned it once more.
+    size_t references;
+};
 
+enum load_result {
+    LOAD_OK,
+    LOAD_FAILED,
+    LOAD_UNSUPPORTED,
+};
 
-static struct data_source *data_source;
 
-static char *readline(FILE *file) {
-    assert(file != NULL);
 
-    size_t line_size = 32;
-    size_t offset = 0;
-    char *line = NULL;
-    size_t add = 32;
+/*
+ * Snapshots are immutable once published, except for the structures built
+ * on first use. Readers pin the published snapshot, so a reload can publish
+ * a new one while they finish with the old one, which is freed by the last
+ * of its references.
+ */
+struct DataSource {
+    const char *paths[2];
+    DataSourceOptions options;
+    Filters filters;
+    struct data_snapshot *published;
+    struct file_version attempted_versions[2];
+    unsigned long last_version;
+    pthread_mutex_t snapshot_lock;
+    pthread_key_t pinned_key;
+    // Guards the structures built on first use, route queries may come from several threads.
+    pthread_mutex_t lazy_build_lock;
+    // Guards the rows and the index of lazily loaded files, so their fields are
+    // served while a hierarchy or landmarks are being built.
+    pthread_mutex_t lazy_row_lock;
+};
 
-    char *tmp;
-    do {
-        tmp = realloc(line, line_size + 1);
-        if (tmp == NULL) {
-            free(line);
-            return NULL;
+// Cached for the rows of lazily loaded files that are invalid, so they are only split once.
+static char *invalid_row[1];
+
+// Data source of the functions without a handle, opened by init_data_source().
+static DataSource *default_source;
+
+/*
+ * A row is complete when it has exactly column_count fields. The first and
+ * the last field must not be empty, which matches the tokens strtok() would
+ * give for the same line.
+ */
+static bool is_complete_row(char **row, int columns, int column_count) {
+    return columns == column_count && row[0][0] != '\0' && row[column_count - 1][0] != '\0';
+}
+
+/*
+ * Splits the text into rows of column_count fields in place. Every ',' and
+ * '\n' is overwritten by '\0' and the cells point right into the text, so no
+ * field is ever copied. If the text does not end with '\n', text[size] has to
+ * be writable. Rows are stored to lines, their fields to consecutive cells.
+ */
+static bool split_csv_text(char *text, size_t size, int column_count, char ***lines, char **cells) {
+    assert(text != NULL || size == 0);
+
+    CsvScanner scanner;
+    csv_scanner_init(&scanner, text, size);
+
+    char **row = cells;
+    int columns = 0;
+    char *field = text;
+
+    for (const char *structural; (structural = csv_scanner_next(&scanner)) != NULL; ) {
+        char *delimiter = text + (structural - text);
+
+        if (columns == column_count) {
+            return false;
         }
+        row[columns++] = field;
+        field = delimiter + 1;
 
-        line = tmp;
-        memset(line + (line_size - add), 0, add);
+        if (*delimiter == '\n') {
+            *delimiter = '\0';
+            if (!is_complete_row(row, columns, column_count)) {
+                return false;
+            }
+            *lines++ = row;
+            row += column_count;
+            columns = 0;
+        } else {
+            *delimiter = '\0';
+        }
+    }
 
-        if (fgets(line + offset, add + 1, file) == NULL) {
-            break;
+    if (field < text + size || columns > 0) {
+        text[size] = '\0';
+        row[columns++] = field;
+        if (!is_complete_row(row, columns, column_count)) {
+            return false;
         }
+        *lines = row;
+    }
 
-        offset = line_size;
-        line_size += add;
+    return true;
+}
 
-    } while (strchr(line, '\n') == NULL);
+// A newline-aligned part of a file, parsed on its own by one thread.
+struct csv_chunk {
+    char *text;
+    size_t size;
+    size_t first_line;
+    size_t line_count;
+    bool valid;
+};
 
-    if (ferror(file) || feof(file)) {
-        free(line);
-        return NULL;
+struct csv_chunks {
+    struct csv_chunk *chunks;
+    int column_count;
+    char ***lines;
+    char **cells;
+};
+
+static void count_chunk_lines(void *context, size_t index) {
+    struct csv_chunk *chunk = &((struct csv_chunks *) context)->chunks[index];
+
+    chunk->line_count = csv_count_newlines(chunk->text, chunk->size);
+    if (chunk->size > 0 && chunk->text[chunk->size - 1] != '\n') {
+        chunk->line_count++;
     }
+}
 
-    line[strlen(line) - 1] = '\0';
+static void split_chunk(void *context, size_t index) {
+    struct csv_chunks *job = context;
+    struct csv_chunk *chunk = &job->chunks[index];
 
-    return line;
+    chunk->valid = split_csv_text(chunk->text, chunk->size, job->column_count,
+                                  job->lines + chunk->first_line,
+                                  job->cells + chunk->first_line * job->column_count);
 }
 
-static void free_pointer_array(void **array, size_t size) {
-    assert(array != NULL);
+/*
+ * Cuts [text, text + size) into chunk_count parts that all end right after
+ * a '\n', except possibly the last one. Parts may end up empty.
+ */
+static void cut_csv_chunks(char *text, size_t size, struct csv_chunk *chunks, size_t chunk_count) {
+    size_t start = 0;
+
+    for (size_t index = 0; index < chunk_count; index++) {
+        size_t end = size;
+
+        if (index + 1 < chunk_count) {
+            end = size / chunk_count * (index + 1);
+            if (end < start) {
+                end = start;
+            }
+            char *newline = memchr(text + end, '\n', size - end);
+            end = newline != NULL ? (size_t) (newline - text) + 1 : size;
+        }
+
+        chunks[index].text = text + start;
+        chunks[index].size = end - start;
+        start = end;
+    }
+}
+
+/*
+ * Builds the row tables of the loaded text. Large texts are cut into
+ * newline-aligned chunks which are parsed in parallel: first every chunk
+ * counts its lines, then each one splits its rows right into its own range
+ * of the tables, so the rows keep the order of the file.
+ *
+ * When tail_writable is false, the byte after the text must not be touched,
+ * so an unterminated last line is split from a copy in the arena.
+ */
+static bool tokenize_csv(struct csv_table *table, int column_count, bool tail_writable) {
+    char *text = table->text;
+    size_t size = table->text_size;
+
+    size_t terminated_size = size;
+    if (!tail_writable) {
+        while (terminated_size > 0 && text[terminated_size - 1] != '\n') {
+            terminated_size--;
+        }
+    }
+
+    size_t worker_count = parallel_worker_count();
+    size_t chunk_count = terminated_size / CSV_PARALLEL_CHUNK_SIZE;
+    if (chunk_count > worker_count) {
+        chunk_count = worker_count;
+    }
+    if (chunk_count == 0) {
+        chunk_count = 1;
+    }
+
+    struct csv_chunks job = { NULL, column_count, NULL, NULL };
+    if ((job.chunks = calloc(chunk_count, sizeof(struct csv_chunk))) == NULL) {
+        return false;
+    }
+
+    cut_csv_chunks(text, terminated_size, job.chunks, chunk_count);
+    parallel_for(chunk_count, worker_count, count_chunk_lines, &job);
 
-    for (size_t index = 0; index < size; index++) {
-        free(array[index]);
+    size_t count = 0;
+    for (size_t index = 0; index < chunk_count; index++) {
+        job.chunks[index].first_line = count;
+        count += job.chunks[index].line_count;
+    }
+    size_t tail_line = count;
+    if (terminated_size < size) {
+        count++;
     }
 
-    free(array);
+    table->count = count;
+    table->lines = job.lines = arena_alloc(&table->arena, (count + 1) * sizeof(char **));
+    job.cells = arena_alloc(&table->arena, (count * column_count + 1) * sizeof(char *));
+    if (job.lines == NULL || job.cells == NULL) {
+        free(job.chunks);
+        return false;
+    }
+    job.lines[count] = NULL;
+
+    parallel_for(chunk_count, worker_count, split_chunk, &job);
+
+    bool valid = true;
+    for (size_t index = 0; index < chunk_count; index++) {
+        valid = valid && job.chunks[index].valid;
+    }
+    free(job.chunks);
+
+    if (valid && terminated_size < size) {
+        char *tail = arena_strndup(&table->arena, text + terminated_size, size - terminated_size);
+        if (tail == NULL) {
+            return false;
+        }
+        return split_csv_text(tail, size - terminated_size, column_count,
+                              job.lines + tail_line, job.cells + tail_line * column_count);
+    }
+
+    return valid;
 }
 
-static void free_splitted_lines(char ***lines, int column_count) {
-    assert(lines != NULL);
+/*
+ * Records where every line starts instead of splitting the lines, which
+ * costs little more than counting them. Rows are split by lazy_row() on
+ * their first use.
+ */
+static bool index_csv_lines(struct csv_table *table) {
+    const char *text = table->text;
+    size_t size = table->text_size;
+
+    size_t count = csv_count_newlines(text, size);
+    if (size > 0 && text[size - 1] != '\n') {
+        count++;
+    }
+    table->line_starts = arena_alloc(&table->arena, (count + 1) * sizeof(size_t));
+    table->lines = arena_alloc(&table->arena, (count + 1) * sizeof(char **));
+    if (table->line_starts == NULL || table->lines == NULL) {
+        return false;
+    }
+    memset(table->lines, 0, (count + 1) * sizeof(char **));
 
-    for (int index = 0; lines[index] != NULL; index++) {
-        free_pointer_array((void **) lines[index], column_count);
+    size_t line = 0;
+    for (size_t offset = 0; offset < size; line++) {
+        table->line_starts[line] = offset;
+        const char *newline = memchr(text + offset, '\n', size - offset);
+        offset = newline != NULL ? (size_t) (newline - text) + 1 : size;
     }
+    table->line_starts[count] = size;
+    table->count = count;
 
-    free(lines);
+    // Rows are used in any order from now on.
+    if (table->mapped) {
+        posix_madvise(table->text, size, POSIX_MADV_RANDOM);
+    }
+    return true;
 }
 
-static char **split_csv_line(char *line, size_t expected_count) {
-    assert(line != NULL);
+/*
+ * Loads a regular file through a private writable mapping. Fields are
+ * terminated in place, so the only allocations are the row tables.
+ */
+static enum load_result map_csv(const char *path, int column_count, bool lazy, struct csv_table *table) {
+    assert(path != NULL && table != NULL);
 
-    char **splitted_line = calloc(expected_count + 1, sizeof(char *));
-    if (splitted_line == NULL) {
-        return NULL;
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) {
+        return LOAD_FAILED;
     }
-    size_t line_length = strlen(line);
 
-    char *token = strtok(line, ",");
-    size_t parsed_length = 0;
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) == -1 || !S_ISREG(file_stat.st_mode)) {
+        close(fd);
+        return LOAD_UNSUPPORTED;
+    }
 
-    for (size_t index = 0; index < expected_count; index++) {
-        if (token == NULL) {
-            free_pointer_array((void **) splitted_line, index);
-            return NULL;
+    size_t size = (size_t) file_stat.st_size;
+    if (size > 0) {
+        table->text = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        if (table->text == MAP_FAILED) {
+            table->text = NULL;
+            close(fd);
+            return LOAD_UNSUPPORTED;
         }
+        table->text_size = size;
+        table->mapped = true;
+        posix_madvise(table->text, size, POSIX_MADV_SEQUENTIAL);
+    }
+    close(fd);
+
+    // Bytes past the end of the file up to the page boundary read as zeros
+    // and can be written, unless the file fills its last page.
+    bool tail_writable = size % (size_t) sysconf(_SC_PAGESIZE) != 0;
+
+    if (lazy) {
+        return index_csv_lines(table) ? LOAD_OK : LOAD_FAILED;
+    }
+    return tokenize_csv(table, column_count, tail_writable) ? LOAD_OK : LOAD_FAILED;
+}
+
+/*
+ * Reads a file that cannot be mapped (a pipe, ...) into a heap buffer.
+ */
+static bool read_csv(const char *path, int column_count, bool lazy, struct csv_table *table) {
+    assert(path != NULL && table != NULL);
+
+    FILE *csv_file = fopen(path, "r");
+    if (csv_file == NULL) {
+        return false;
+    }
 
-        parsed_length += strlen(token) + 1;
+    size_t capacity = 0;
+    size_t size = 0;
+    char *text = NULL;
 
-        splitted_line[index] = malloc(strlen(token) + 1);
-        if (splitted_line[index] == NULL) {
-            free_pointer_array((void **) splitted_line, index);
-            return NULL;
+    do {
+        if (capacity - size < CSV_READ_CHUNK_SIZE) {
+            capacity = capacity * 2 + CSV_READ_CHUNK_SIZE;
+            char *tmp = realloc(text, capacity + 1);
+            if (tmp == NULL) {
+                free(text);
+                fclose(csv_file);
+                return false;
+            }
+            text = tmp;
         }
+        size += fread(text + size, 1, capacity - size, csv_file);
+    } while (!feof(csv_file) && !ferror(csv_file));
 
-        strcpy(splitted_line[index], token);
+    if (ferror(csv_file)) {
+        free(text);
+        fclose(csv_file);
+        return false;
+    }
+    fclose(csv_file);
 
-        if (line_length > parsed_length
-            && strchr(line + parsed_length, ',') == line + parsed_length) {
-            token = "";
-        } else {
-            token = strtok(NULL, ",");
+    table->text = text;
+    table->text_size = size;
+
+    return lazy ? index_csv_lines(table) : tokenize_csv(table, column_count, true);
+}
+
+static void free_csv(struct csv_table *table) {
+    if (table->mapped) {
+        munmap(table->text, table->text_size);
+    } else {
+        free(table->text);
+    }
+    arena_free(&table->arena);
+}
+
+static bool load_csv(const char *path, int column_count, bool lazy, struct csv_table *table) {
+    memset(table, 0, sizeof(*table));
+    arena_init(&table->arena, CSV_ARENA_CHUNK_SIZE);
+
+    enum load_result result = map_csv(path, column_count, lazy, table);
+
+    // Pipes and other special files cannot be mapped, read them instead.
+    if (result == LOAD_UNSUPPORTED) {
+        result = read_csv(path, column_count, lazy, table) ? LOAD_OK : LOAD_FAILED;
+    }
+
+    if (result != LOAD_OK) {
+        free_csv(table);
+        return false;
+    }
+
+    return true;
+}
+
+// One of the input files, loaded on its own thread by init_data_source().
+struct csv_load {
+    const char *path;
+    int column_count;
+    bool lazy;
+    struct csv_table *table;
+    bool loaded;
+};
+
+static void load_csv_task(void *context, size_t index) {
+    struct csv_load *load = &((struct csv_load *) context)[index];
+
+    load->loaded = load_csv(load->path, load->column_count, load->lazy, load->table);
+}
+
+static void destroy_tables(struct data_snapshot *source) {
+    // Tables mapped from a snapshot file go away with the mapping, the hierarchy as well.
+    if (source->mapping.address != NULL) {
+        snapshot_file_unmap(&source->mapping);
+    } else {
+        container_table_destroy(&source->container_table);
+        path_table_destroy(&source->path_table);
+        id_index_destroy(&source->container_index);
+        graph_destroy(&source->container_graph);
+        station_table_destroy(&source->station_table);
+        hierarchy_destroy(&source->station_hierarchy);
+    }
+    source->station_hierarchy_built = false;
+    landmarks_destroy(&source->station_landmarks);
+    source->station_landmarks_built = false;
+}
+
+/*
+ * Only the columns in the mask are stored, and with filters, only the
+ * containers passing them get their name and street interned. Every row is
+ * still converted and validated, so the rows, the index and the neighbors
+ * stay the same as with all the columns.
+ */
+static bool build_container_table(struct data_snapshot *source, const DataSourceOptions *options) {
+    const ContainerColumns strings = CONTAINER_COLUMN_NAME | CONTAINER_COLUMN_STREET;
+    ContainerTable *table = &source->container_table;
+    if (!container_table_init(table, source->containers.count)) {
+        return false;
+    }
+    for (size_t index = 0; index < source->containers.count; index++) {
+        const char *const *fields = (const char *const *) source->containers.lines[index];
+        if (!container_table_set_columns(table, index, fields, options->columns & ~strings)) {
+            return false;
+        }
+        if ((options->filters == NULL || container_matches_filters(table, index, *options->filters))
+            && !container_table_set_strings(table, index, fields, options->columns)) {
+            return false;
         }
     }
+    source->partial = options->filters != NULL || options->columns != CONTAINER_COLUMNS_ALL;
 
-    if (token != NULL) {
-        free_pointer_array((void **) splitted_line, expected_count);
-        return NULL;
+    bool duplicate;
+    return id_index_build(&source->container_index, table->id, table->count, &duplicate);
+}
+
+static bool build_path_table(struct data_snapshot *source) {
+    if (!path_table_init(&source->path_table, source->paths.count)) {
+        return false;
+    }
+    for (size_t index = 0; index < source->paths.count; index++) {
+        if (!path_table_set(&source->path_table, index, (const char *const *) source->paths.lines[index])) {
+            return false;
+        }
     }
 
-    return splitted_line;
+    return path_table_resolve(&source->path_table, &source->container_index);
 }
 
-static char ***parse_csv(const char *path, int column_count) {
-    assert(path != NULL);
+struct id_row {
+    uint64_t id;
+    size_t row;
+};
 
-    FILE *csv_file = fopen(path, "r");
+static int compare_id_rows(const void *a, const void *b) {
+    uint64_t id_a = ((const struct id_row *) a)->id;
+    uint64_t id_b = ((const struct id_row *) b)->id;
+    return (id_a > id_b) - (id_a < id_b);
+}
 
-    if (csv_file == NULL) {
-        return NULL;
+/*
+ * Builds the graph of containers connected by paths. Repeated paths and
+ * paths listed in both directions are kept once and neighbors are ordered
+ * by their IDs.
+ */
+static bool build_container_graph(struct data_snapshot *source) {
+    const ContainerTable *containers = &source->container_table;
+
+    struct id_row *order = malloc((containers->count + 1) * sizeof(struct id_row));
+    size_t *rank = malloc((containers->count + 1) * sizeof(size_t));
+    if (order == NULL || rank == NULL) {
+        free(order);
+        free(rank);
+        return false;
     }
 
-    size_t array_capacity = 8;
-    size_t line_count = 0;
-    char ***lines = calloc(array_capacity + 1, sizeof(char **));
+    for (size_t row = 0; row < containers->count; row++) {
+        order[row].id = containers->id[row];
+        order[row].row = row;
+    }
+    qsort(order, containers->count, sizeof(struct id_row), compare_id_rows);
+    for (size_t position = 0; position < containers->count; position++) {
+        rank[order[position].row] = position;
+    }
+    free(order);
 
-    if (lines == NULL) {
-        fclose(csv_file);
-        return NULL;
+    const PathTable *paths = &source->path_table;
+    GraphEdges edges = { paths->count, paths->a_row, paths->b_row, paths->distance };
+    bool built = graph_build(&source->container_graph, containers->count, &edges, rank);
+
+    free(rank);
+    return built;
+}
+
+// Converts every row of both files to the typed tables and indexes them. Stations
+// are only grouped when their columns were converted.
+static bool build_tables(struct data_snapshot *source, const DataSourceOptions *options) {
+    memset(&source->container_table, 0, sizeof(source->container_table));
+    memset(&source->path_table, 0, sizeof(source->path_table));
+    memset(&source->container_index, 0, sizeof(source->container_index));
+    memset(&source->container_graph, 0, sizeof(source->container_graph));
+    memset(&source->station_table, 0, sizeof(source->station_table));
+    memset(&source->station_hierarchy, 0, sizeof(source->station_hierarchy));
+    source->station_hierarchy_built = false;
+    memset(&source->station_landmarks, 0, sizeof(source->station_landmarks));
+    source->station_landmarks_built = false;
+
+    bool stations = (options->columns & DATA_SOURCE_STATION_COLUMNS) == DATA_SOURCE_STATION_COLUMNS;
+    if (!build_container_table(source, options) || !build_path_table(source) || !build_container_graph(source)
+        || (stations
+            && !station_table_build(&source->station_table, &source->container_table, &source->container_graph))) {
+        destroy_tables(source);
+        return false;
     }
 
-    char *line;
-    void *tmp;
+    return true;
+}
 
-    while ((line = readline(csv_file)) != NULL) {
-        if (line_count >= array_capacity) {
-            tmp = realloc(lines, (array_capacity * 2 + 1) * sizeof(char **));
-            if (tmp == NULL) {
-                free(line);
-                free_splitted_lines(lines, column_count);
-                fclose(csv_file);
-                return NULL;
+// Returns the snapshot pinned by the calling thread, or the published one.
+static struct data_snapshot *current_snapshot(DataSource *source) {
+    struct data_snapshot *pinned = pthread_getspecific(source->pinned_key);
+    return pinned != NULL ? pinned : source->published;
+}
+
+// Missing files get a zero version, so they differ from any file that can be loaded.
+static void read_file_version(const char *path, struct file_version *version) {
+    struct stat status;
+    memset(version, 0, sizeof(*version));
+    if (stat(path, &status) == 0) {
+        version->device = status.st_dev;
+        version->inode = status.st_ino;
+        version->size = status.st_size;
+        version->modified = status.st_mtime;
+    }
+}
+
+static bool same_file_version(const struct file_version *a, const struct file_version *b) {
+    return a->device == b->device && a->inode == b->inode && a->size == b->size && a->modified == b->modified;
+}
+
+static void free_snapshot(struct data_snapshot *snapshot) {
+    destroy_tables(snapshot);
+    id_index_destroy(&snapshot->lazy_index);
+    free(snapshot->indexed_lines);
+    free_csv(&snapshot->containers);
+    free_csv(&snapshot->paths);
+    free(snapshot);
+}
+
+static void release_snapshot(DataSource *source, struct data_snapshot *snapshot) {
+    pthread_mutex_lock(&source->snapshot_lock);
+    bool last = --snapshot->references == 0;
+    pthread_mutex_unlock(&source->snapshot_lock);
+
+    if (last) {
+        free_snapshot(snapshot);
+    }
+}
+
+// Points the tables of the snapshot into a mapped snapshot file or shared memory object.
+static void use_snapshot_data(struct data_snapshot *snapshot, const SnapshotData *data) {
+    snapshot->container_table = data->containers;
+    snapshot->path_table = data->paths;
+    snapshot->container_index = data->index;
+    snapshot->container_graph = data->container_graph;
+    snapshot->station_table = data->stations;
+    snapshot->station_hierarchy = data->hierarchy;
+    snapshot->station_hierarchy_built = true;
+    snapshot->containers.count = data->container_fields.row_count;
+    snapshot->containers.field_offsets = data->container_fields.offsets;
+    snapshot->containers.field_text = data->container_fields.text;
+    snapshot->containers.field_text_size = data->container_fields.text_size;
+    snapshot->paths.count = data->path_fields.row_count;
+    snapshot->paths.field_offsets = data->path_fields.offsets;
+    snapshot->paths.field_text = data->path_fields.text;
+    snapshot->paths.field_text_size = data->path_fields.text_size;
+}
+
+// Describes the tables of the snapshot for writing them out, its hierarchy must be built.
+static void get_snapshot_data(const struct data_snapshot *snapshot, SnapshotData *data) {
+    data->containers = snapshot->container_table;
+    data->paths = snapshot->path_table;
+    data->index = snapshot->container_index;
+    data->container_graph = snapshot->container_graph;
+    data->stations = snapshot->station_table;
+    data->hierarchy = snapshot->station_hierarchy;
+
+    const struct csv_table *tables[] = { &snapshot->containers, &snapshot->paths };
+    SnapshotFields *fields[] = { &data->container_fields, &data->path_fields };
+    const size_t column_counts[] = { CONTAINER_COLUMNS_COUNT, PATH_COLUMNS_COUNT };
+    for (size_t index = 0; index < 2; index++) {
+        memset(fields[index], 0, sizeof(*fields[index]));
+        fields[index]->row_count = tables[index]->count;
+        fields[index]->column_count = column_counts[index];
+        fields[index]->lines = tables[index]->lines;
+        fields[index]->offsets = tables[index]->field_offsets;
+        fields[index]->text = tables[index]->field_text;
+        fields[index]->text_size = tables[index]->field_text_size;
+    }
+}
+
+/*
+ * The shared memory object is named after the device and inode of both
+ * input files, so every process loading the same files finds it without
+ * being told its name. Whether the files changed since it was written is
+ * told by their sizes and modification times, like for snapshot files.
+ */
+static void get_shared_name(const struct file_version versions[2], char name[SHARED_NAME_SIZE]) {
+    snprintf(name, SHARED_NAME_SIZE, "/container-explorer-%jx-%jx-%jx-%jx",
+             (uintmax_t) versions[0].device, (uintmax_t) versions[0].inode,
+             (uintmax_t) versions[1].device, (uintmax_t) versions[1].inode);
+}
+
+// Maps the tables from the shared memory object of the input files, or from the snapshot file.
+static bool map_snapshot_data(struct data_snapshot *snapshot, const DataSourceOptions *options) {
+    if (!snapshot->sources_known) {
+        return false;
+    }
+
+    char shared_name[SHARED_NAME_SIZE];
+    get_shared_name(snapshot->versions, shared_name);
+    SnapshotData data;
+    if (snapshot_shm_map(shared_name, snapshot->sources, options->verify_snapshot, &data, &snapshot->mapping)
+        || (options->snapshot_path != NULL
+            && snapshot_file_map(options->snapshot_path, snapshot->sources, options->verify_snapshot, &data,
+                                 &snapshot->mapping))) {
+        use_snapshot_data(snapshot, &data);
+        return true;
+    }
+    return false;
+}
+
+/*
+ * Loads both files into a new snapshot with a single reference, NULL on
+ * failure. Tables published to shared memory or to a snapshot file from
+ * the same files are used in place of them, so nothing needs to be parsed.
+ */
+static struct data_snapshot *load_snapshot(const char *containers_path, const char *paths_path,
+                                           const DataSourceOptions *options) {
+    struct data_snapshot *snapshot = malloc(sizeof(struct data_snapshot));
+    if (snapshot == NULL) {
+        return NULL;
+    }
+    memset(snapshot, 0, sizeof(*snapshot));
+    read_file_version(containers_path, &snapshot->versions[0]);
+    read_file_version(paths_path, &snapshot->versions[1]);
+    snapshot->sources_known = snapshot_source_read(containers_path, &snapshot->sources[0])
+                              && snapshot_source_read(paths_path, &snapshot->sources[1]);
+    snapshot->references = 1;
+
+    if (map_snapshot_data(snapshot, options)) {
+        return snapshot;
+    }
+
+    // Both files are independent until their rows are used, so they are
+    // loaded at the same time.
+    struct csv_load loads[] = {
+        { containers_path, CONTAINER_COLUMNS_COUNT, options->lazy, &snapshot->containers, false },
+        { paths_path, PATH_COLUMNS_COUNT, options->lazy, &snapshot->paths, false },
+    };
+    parallel_for(2, 2, load_csv_task, loads);
+
+    // Lazily loaded files only serve their fields, no table is built from them.
+    snapshot->partial = options->lazy;
+    if (!loads[0].loaded || !loads[1].loaded || (!options->lazy && !build_tables(snapshot, options))) {
+        for (size_t index = 0; index < 2; index++) {
+            if (loads[index].loaded) {
+                free_csv(loads[index].table);
             }
-            lines = tmp;
-            memset(lines + line_count, 0, (array_capacity + 1) * sizeof(char **));
-            array_capacity *= 2;
         }
+        free(snapshot);
+        return NULL;
+    }
 
-        if ((lines[line_count] = split_csv_line(line, column_count)) == NULL) {
-            free(line);
-            free_splitted_lines(lines, column_count);
-            fclose(csv_file);
-            return NULL;
+    return snapshot;
+}
+
+DataSource *data_source_open(const char *containers_path, const char *paths_path) {
+    DataSourceOptions options = { NULL, NULL, CONTAINER_COLUMNS_ALL, false, false };
+    return data_source_open_with(containers_path, paths_path, &options);
+}
+
+DataSource *data_source_open_snapshot(const char *containers_path, const char *paths_path,
+                                      const char *snapshot_path) {
+    DataSourceOptions options = { snapshot_path, NULL, CONTAINER_COLUMNS_ALL, false, false };
+    return data_source_open_with(containers_path, paths_path, &options);
+}
+
+DataSource *data_source_open_with(const char *containers_path, const char *paths_path,
+                                  const DataSourceOptions *options) {
+    DataSource *source = malloc(sizeof(DataSource));
+    if (source == NULL) {
+        return NULL;
+    }
+    // Reloads use the same options, the filters are kept by value.
+    source->options = *options;
+    if (options->filters != NULL) {
+        source->filters = *options->filters;
+        source->options.filters = &source->filters;
+    }
+    if (pthread_key_create(&source->pinned_key, NULL) != 0) {
+        free(source);
+        return NULL;
+    }
+    source->published = load_snapshot(containers_path, paths_path, &source->options);
+    if (source->published == NULL) {
+        pthread_key_delete(source->pinned_key);
+        free(source);
+        return NULL;
+    }
+
+    source->paths[0] = containers_path;
+    source->paths[1] = paths_path;
+    source->attempted_versions[0] = source->published->versions[0];
+    source->attempted_versions[1] = source->published->versions[1];
+    source->published->version = source->last_version = 1;
+    pthread_mutex_init(&source->snapshot_lock, NULL);
+    pthread_mutex_init(&source->lazy_build_lock, NULL);
+    pthread_mutex_init(&source->lazy_row_lock, NULL);
+    return source;
+}
+
+bool data_source_snapshot_mapped(DataSource *source) {
+    return current_snapshot(source)->mapping.address != NULL;
+}
+
+bool data_source_write_snapshot(DataSource *source, const char *snapshot_path) {
+    struct data_snapshot *snapshot = current_snapshot(source);
+    // The hierarchy is contracted once here and saved, not by every process answering routes.
+    if (!snapshot->sources_known || snapshot->partial || data_source_station_hierarchy(source) == NULL) {
+        return false;
+    }
+
+    SnapshotData data;
+    get_snapshot_data(snapshot, &data);
+    return snapshot_file_write(snapshot_path, &data, snapshot->sources);
+}
+
+bool data_source_publish_shared(DataSource *source) {
+    struct data_snapshot *snapshot = current_snapshot(source);
+    if (!snapshot->sources_known || snapshot->partial || data_source_station_hierarchy(source) == NULL) {
+        return false;
+    }
+
+    char shared_name[SHARED_NAME_SIZE];
+    get_shared_name(snapshot->versions, shared_name);
+    SnapshotData data;
+    get_snapshot_data(snapshot, &data);
+    return snapshot_shm_write(shared_name, &data, snapshot->sources);
+}
+
+bool data_source_remove_shared(DataSource *source) {
+    char shared_name[SHARED_NAME_SIZE];
+    get_shared_name(current_snapshot(source)->versions, shared_name);
+    return snapshot_shm_remove(shared_name);
+}
+
+bool data_source_remove_shared_files(const char *containers_path, const char *paths_path) {
+    struct file_version versions[2];
+    read_file_version(containers_path, &versions[0]);
+    read_file_version(paths_path, &versions[1]);
+
+    char shared_name[SHARED_NAME_SIZE];
+    get_shared_name(versions, shared_name);
+    return snapshot_shm_remove(shared_name);
+}
+
+void data_source_close(DataSource *source) {
+    if (source == NULL) {
+        return;
+    }
+
+    release_snapshot(source, source->published);
+    pthread_key_delete(source->pinned_key);
+    pthread_mutex_destroy(&source->snapshot_lock);
+    pthread_mutex_destroy(&source->lazy_build_lock);
+    pthread_mutex_destroy(&source->lazy_row_lock);
+    free(source);
+}
+
+bool data_source_reload(DataSource *source) {
+    // A file that changes while it loads must look changed to the next check.
+    struct file_version versions[2];
+    read_file_version(source->paths[0], &versions[0]);
+    read_file_version(source->paths[1], &versions[1]);
+    struct data_snapshot *snapshot = load_snapshot(source->paths[0], source->paths[1], &source->options);
+
+    pthread_mutex_lock(&source->snapshot_lock);
+    source->attempted_versions[0] = versions[0];
+    source->attempted_versions[1] = versions[1];
+    if (snapshot != NULL) {
+        snapshot->version = ++source->last_version;
+        struct data_snapshot *old = source->published;
+        source->published = snapshot;
+        snapshot = old;
+    }
+    pthread_mutex_unlock(&source->snapshot_lock);
+
+    if (snapshot == NULL) {
+        return false;
+    }
+    release_snapshot(source, snapshot);
+    return true;
+}
+
+bool data_source_changed(DataSource *source) {
+    struct file_version versions[2];
+    read_file_version(source->paths[0], &versions[0]);
+    read_file_version(source->paths[1], &versions[1]);
+
+    pthread_mutex_lock(&source->snapshot_lock);
+    bool changed = !same_file_version(&versions[0], &source->attempted_versions[0])
+                   || !same_file_version(&versions[1], &source->attempted_versions[1]);
+    pthread_mutex_unlock(&source->snapshot_lock);
+    return changed;
+}
+
+void data_source_pin(DataSource *source) {
+    assert(pthread_getspecific(source->pinned_key) == NULL);
+
+    pthread_mutex_lock(&source->snapshot_lock);
+    struct data_snapshot *snapshot = source->published;
+    snapshot->references++;
+    pthread_mutex_unlock(&source->snapshot_lock);
+
+    pthread_setspecific(source->pinned_key, snapshot);
+}
+
+void data_source_unpin(DataSource *source) {
+    struct data_snapshot *snapshot = pthread_getspecific(source->pinned_key);
+    assert(snapshot != NULL);
+
+    pthread_setspecific(source->pinned_key, NULL);
+    release_snapshot(source, snapshot);
+}
+
+unsigned long data_source_version(DataSource *source) {
+    return current_snapshot(source)->version;
+}
+
+/*
+ * Splits a row of a lazily loaded table. The row is copied, as the text of
+ * a mapped file cannot always be terminated in place. An invalid row is
+ * cached as invalid_row. Returns NULL on allocation failure, which leaves
+ * the row to be split again.
+ */
+static char **lazy_row(struct csv_table *table, size_t row, int column_count) {
+    size_t start = table->line_starts[row];
+    size_t end = table->line_starts[row + 1];
+    if (end > start && table->text[end - 1] == '\n') {
+        end--;
+    }
+
+    char *line = arena_strndup(&table->arena, table->text + start, end - start);
+    char **cells = arena_alloc(&table->arena, column_count * sizeof(char *));
+    if (line == NULL || cells == NULL) {
+        return NULL;
+    }
+    char **fields = NULL;
+    if (!split_csv_text(line, end - start, column_count, &fields, cells)) {
+        fields = invalid_row;
+    }
+    return table->lines[row] = fields;
+}
+
+// Splits every row of a lazily loaded table, false if one of them is invalid.
+static bool split_lazy_rows(struct csv_table *table, int column_count) {
+    for (size_t row = 0; row < table->count; row++) {
+        char **fields = table->lines[row] != NULL ? table->lines[row] : lazy_row(table, row, column_count);
+        if (fields == NULL || fields == invalid_row) {
+            return false;
         }
+    }
+    return true;
+}
 
-        line_count++;
-        free(line);
+/*
+ * Builds the typed tables of lazily loaded files on the first call that
+ * needs them, from the rows split as the field accessors split them. The
+ * files are validated then like by an eager load, and if they are invalid,
+ * the tables stay empty and every later call returns false at once.
+ */
+static bool lazy_tables(DataSource *source, struct data_snapshot *snapshot) {
+    if (snapshot->containers.line_starts == NULL) {
+        return true;
     }
 
-    if (ferror(csv_file)) {
-        free_splitted_lines(lines, column_count);
-        fclose(csv_file);
+    pthread_mutex_lock(&source->lazy_row_lock);
+    if (!snapshot->lazy_tables_built && !snapshot->lazy_tables_failed) {
+        snapshot->lazy_tables_built = split_lazy_rows(&snapshot->containers, CONTAINER_COLUMNS_COUNT)
+                                      && split_lazy_rows(&snapshot->paths, PATH_COLUMNS_COUNT)
+                                      && build_tables(snapshot, &source->options);
+        snapshot->lazy_tables_failed = !snapshot->lazy_tables_built;
+        // The rows stay in the arenas of the files, which a snapshot file does not hold.
+        snapshot->partial = true;
+    }
+    bool built = snapshot->lazy_tables_built;
+    pthread_mutex_unlock(&source->lazy_row_lock);
+    return built;
+}
+
+const ContainerTable *data_source_container_table(DataSource *source) {
+    struct data_snapshot *snapshot = current_snapshot(source);
+    lazy_tables(source, snapshot);
+    return &snapshot->container_table;
+}
+
+const PathTable *data_source_path_table(DataSource *source) {
+    struct data_snapshot *snapshot = current_snapshot(source);
+    lazy_tables(source, snapshot);
+    return &snapshot->path_table;
+}
+
+const Graph *data_source_container_graph(DataSource *source) {
+    struct data_snapshot *snapshot = current_snapshot(source);
+    lazy_tables(source, snapshot);
+    return &snapshot->container_graph;
+}
+
+const StationTable *data_source_station_table(DataSource *source) {
+    struct data_snapshot *snapshot = current_snapshot(source);
+    lazy_tables(source, snapshot);
+    return &snapshot->station_table;
+}
+
+const ContractionHierarchy *data_source_station_hierarchy(DataSource *source) {
+    struct data_snapshot *snapshot = current_snapshot(source);
+    if (!lazy_tables(source, snapshot)) {
         return NULL;
     }
+    pthread_mutex_lock(&source->lazy_build_lock);
+    if (!snapshot->station_hierarchy_built) {
+        snapshot->station_hierarchy_built = hierarchy_build(&snapshot->station_hierarchy,
+                                                            &snapshot->station_table.graph);
+    }
+    bool built = snapshot->station_hierarchy_built;
+    pthread_mutex_unlock(&source->lazy_build_lock);
+    return built ? &snapshot->station_hierarchy : NULL;
+}
 
-    fclose(csv_file);
-    return lines;
+const Landmarks *data_source_station_landmarks(DataSource *source) {
+    struct data_snapshot *snapshot = current_snapshot(source);
+    if (!lazy_tables(source, snapshot)) {
+        return NULL;
+    }
+    pthread_mutex_lock(&source->lazy_build_lock);
+    if (!snapshot->station_landmarks_built) {
+        snapshot->station_landmarks_built = landmarks_build(&snapshot->station_landmarks,
+                                                            &snapshot->station_table.graph, STATION_LANDMARK_COUNT);
+    }
+    bool built = snapshot->station_landmarks_built;
+    pthread_mutex_unlock(&source->lazy_build_lock);
+    return built ? &snapshot->station_landmarks : NULL;
 }
 
-static size_t count_lines(void **lines) {
-    size_t lines_count = 0;
-    while (lines[lines_count] != NULL) {
-        lines_count++;
+// An ID at the start of a line of a lazily loaded table.
+struct line_id {
+    uint64_t id;
+    size_t line;
+};
+
+static int compare_line_ids(const void *a, const void *b) {
+    const struct line_id *line_a = a;
+    const struct line_id *line_b = b;
+    if (line_a->id != line_b->id) {
+        return (line_a->id > line_b->id) - (line_a->id < line_b->id);
     }
-    return lines_count;
+    return (line_a->line > line_b->line) - (line_a->line < line_b->line);
 }
 
-bool init_data_source(const char *containers_path, const char *paths_path) {
-    data_source = malloc(sizeof(struct data_source));
-    if (data_source == NULL) {
+// Parses the ID at the start of the line without splitting it.
+static bool read_line_id(const struct csv_table *table, size_t row, uint64_t *id) {
+    char digits[24];
+    const char *line = table->text + table->line_starts[row];
+    size_t length = 0;
+    size_t line_length = table->line_starts[row + 1] - table->line_starts[row];
+    while (length < line_length && length < sizeof(digits) && line[length] != ',' && line[length] != '\n') {
+        length++;
+    }
+    if (length == sizeof(digits)) {
         return false;
     }
-    data_source->containers = parse_csv(containers_path, CONTAINER_COLUMNS_COUNT);
-    if (data_source->containers == NULL) {
-        free(data_source);
+
+    memcpy(digits, line, length);
+    digits[length] = '\0';
+    return parse_unsigned(digits, UINT64_MAX, id);
+}
+
+/*
+ * Indexes the IDs at the starts of the lines of lazily loaded containers.
+ * Lines whose ID does not parse are left out, and so are IDs starting
+ * several lines, as none of them is the container of the ID.
+ */
+static bool index_lazy_containers(struct data_snapshot *snapshot) {
+    const struct csv_table *table = &snapshot->containers;
+    struct line_id *line_ids = malloc((table->count + 1) * sizeof(struct line_id));
+    if (line_ids == NULL) {
+        return false;
+    }
+    size_t count = 0;
+    for (size_t row = 0; row < table->count; row++) {
+        if (read_line_id(table, row, &line_ids[count].id)) {
+            line_ids[count++].line = row;
+        }
+    }
+    qsort(line_ids, count, sizeof(struct line_id), compare_line_ids);
+
+    uint64_t *ids = malloc((count + 1) * sizeof(uint64_t));
+    size_t *lines = malloc((count + 1) * sizeof(size_t));
+    if (ids == NULL || lines == NULL) {
+        free(line_ids);
+        free(ids);
+        free(lines);
         return false;
     }
-    data_source->containers_count = count_lines((void **) data_source->containers);
+    size_t kept = 0;
+    for (size_t index = 0; index < count; ) {
+        size_t next = index + 1;
+        while (next < count && line_ids[next].id == line_ids[index].id) {
+            next++;
+        }
+        if (next == index + 1) {
+            ids[kept] = line_ids[index].id;
+            lines[kept++] = line_ids[index].line;
+        }
+        index = next;
+    }
+    free(line_ids);
 
-    data_source->paths = parse_csv(paths_path, PATH_COLUMNS_COUNT);
-    if (data_source->paths == NULL) {
-        free_splitted_lines(data_source->containers, CONTAINER_COLUMNS_COUNT);
-        free(data_source);
+    bool duplicate;
+    bool built = id_index_build(&snapshot->lazy_index, ids, kept, &duplicate);
+    free(ids);
+    if (!built) {
+        free(lines);
         return false;
     }
-    data_source->paths_count = count_lines((void **) data_source->paths);
+    snapshot->indexed_lines = lines;
+    return true;
+}
 
+/*
+ * Looks the ID up in the index built on the first lookup. The row found is
+ * split as well, so a container is only found if its fields can be read.
+ */
+static bool find_lazy_container(DataSource *source, struct data_snapshot *snapshot, uint64_t id,
+                                size_t *line_index) {
+    struct csv_table *table = &snapshot->containers;
+    pthread_mutex_lock(&source->lazy_row_lock);
+    if (!snapshot->lazy_index_built) {
+        snapshot->lazy_index_built = index_lazy_containers(snapshot);
+    }
+    size_t row = snapshot->lazy_index_built ? id_index_find(&snapshot->lazy_index, id) : ID_INDEX_NOT_FOUND;
+    char **fields = NULL;
+    if (row != ID_INDEX_NOT_FOUND) {
+        row = snapshot->indexed_lines[row];
+        fields = table->lines[row] != NULL ? table->lines[row] : lazy_row(table, row, CONTAINER_COLUMNS_COUNT);
+    }
+    pthread_mutex_unlock(&source->lazy_row_lock);
+
+    if (fields == NULL || fields == invalid_row) {
+        return false;
+    }
+    *line_index = row;
     return true;
 }
 
-void destroy_data_source(void) {
-    free_splitted_lines(data_source->containers, CONTAINER_COLUMNS_COUNT);
-    free_splitted_lines(data_source->paths, PATH_COLUMNS_COUNT);
-    free(data_source);
+bool data_source_find_container(DataSource *source, uint64_t id, size_t *line_index) {
+    struct data_snapshot *snapshot = current_snapshot(source);
+    if (snapshot->containers.line_starts != NULL) {
+        return find_lazy_container(source, snapshot, id, line_index);
+    }
+    size_t row = id_index_find(&snapshot->container_index, id);
+    if (row == ID_INDEX_NOT_FOUND) {
+        return false;
+    }
+
+    *line_index = row;
+    return true;
 }
 
-const char *get_container_id(size_t line_index) {
-    if (line_index >= data_source->containers_count) {
+// Returns a field of the row wherever the table keeps it, or NULL if the row of a lazily loaded table is invalid.
+static const char *csv_field(DataSource *source, struct csv_table *table, size_t row, size_t column,
+                             int column_count) {
+    if (table->line_starts != NULL) {
+        // Rows may be split by several threads at once.
+        pthread_mutex_lock(&source->lazy_row_lock);
+        char **fields = table->lines[row] != NULL ? table->lines[row] : lazy_row(table, row, column_count);
+        pthread_mutex_unlock(&source->lazy_row_lock);
+        return fields != NULL && fields != invalid_row ? fields[column] : NULL;
+    }
+    if (table->lines != NULL) {
+        return table->lines[row][column];
+    }
+    return table->field_text + table->field_offsets[row * column_count + column];
+}
+
+const char *data_source_container_id(DataSource *source, size_t line_index) {
+    struct data_snapshot *snapshot = current_snapshot(source);
+    if (line_index >= snapshot->containers.count) {
         return NULL;
     }
-    return data_source->containers[line_index][CONTAINER_ID];
+    return csv_field(source, &snapshot->containers, line_index, CONTAINER_ID, CONTAINER_COLUMNS_COUNT);
 }
 
-const char *get_container_x(size_t line_index) {
-    if (line_index >= data_source->containers_count) {
+const char *data_source_container_x(DataSource *source, size_t line_index) {
+    struct data_snapshot *snapshot = current_snapshot(source);
+    if (line_index >= snapshot->containers.count) {
         return NULL;
     }
-    return data_source->containers[line_index][CONTAINER_X];
+    return csv_field(source, &snapshot->containers, line_index, CONTAINER_X, CONTAINER_COLUMNS_COUNT);
 }
 
-const char *get_container_y(size_t line_index) {
-    if (line_index >= data_source->containers_count) {
+const char *data_source_container_y(DataSource *source, size_t line_index) {
+    struct data_snapshot *snapshot = current_snapshot(source);
+    if (line_index >= snapshot->containers.count) {
         return NULL;
     }
-    return data_source->containers[line_index][CONTAINER_Y];
+    return csv_field(source, &snapshot->containers, line_index, CONTAINER_Y, CONTAINER_COLUMNS_COUNT);
 }
 
-const char *get_container_waste_type(size_t line_index) {
-    if (line_index >= data_source->containers_count) {
+const char *data_source_container_waste_type(DataSource *source, size_t line_index) {
+    struct data_snapshot *snapshot = current_snapshot(source);
+    if (line_index >= snapshot->containers.count) {
         return NULL;
     }
-    return data_source->containers[line_index][CONTAINER_WASTE_TYPE];
+    return csv_field(source, &snapshot->containers, line_index, CONTAINER_WASTE_TYPE, CONTAINER_COLUMNS_COUNT);
 }
 
-const char *get_path_a_id(size_t line_index) {
-    if (line_index >= data_source->paths_count) {
+const char *data_source_container_capacity(DataSource *source, size_t line_index) {
+    struct data_snapshot *snapshot = current_snapshot(source);
+    if (line_index >= snapshot->containers.count) {
         return NULL;
     }
-    return data_source->paths[line_index][PATH_A];
+    return csv_field(source, &snapshot->containers, line_index, CONTAINER_CAPACITY, CONTAINER_COLUMNS_COUNT);
 }
 
-const char *get_path_b_id(size_t line_index) {
-    if (line_index >= data_source->paths_count) {
+const char *data_source_container_name(DataSource *source, size_t line_index) {
+    struct data_snapshot *snapshot = current_snapshot(source);
+    if (line_index >= snapshot->containers.count) {
         return NULL;
     }
-    return data_source->paths[line_index][PATH_B];
+    return csv_field(source, &snapshot->containers, line_index, CONTAINER_NAME, CONTAINER_COLUMNS_COUNT);
 }
 
-const char *get_path_distance(size_t line_index) {
-    if (line_index >= data_source->paths_count) {
+const char *data_source_container_street(DataSource *source, size_t line_index) {
+    struct data_snapshot *snapshot = current_snapshot(source);
+    if (line_index >= snapshot->containers.count) {
+        return NULL;
+    }
+    return csv_field(source, &snapshot->containers, line_index, CONTAINER_STREET, CONTAINER_COLUMNS_COUNT);
+}
+
+const char *data_source_container_number(DataSource *source, size_t line_index) {
+    struct data_snapshot *snapshot = current_snapshot(source);
+    if (line_index >= snapshot->containers.count) {
         return NULL;
     }
-    return data_source->paths[line_index][PATH_DISTANCE];
+    return csv_field(source, &snapshot->containers, line_index, CONTAINER_NUMBER, CONTAINER_COLUMNS_COUNT);
 }
 
-Neighbor *find_neighbors(const char *given_container_id, size_t *neighbors_count) {
-    Neighbor *neighbors = NULL;
-    *neighbors_count = 0;
+const char *data_source_container_public(DataSource *source, size_t line_index) {
+    struct data_snapshot *snapshot = current_snapshot(source);
+    if (line_index >= snapshot->containers.count) {
+        return NULL;
+    }
+    return csv_field(source, &snapshot->containers, line_index, CONTAINER_PUBLIC, CONTAINER_COLUMNS_COUNT);
+}
 
-    for (size_t i = 0; i < data_source->paths_count; i++) {
-        const char *container_a_id = get_path_a_id(i);
-        const char *container_b_id = get_path_b_id(i);
+const char *data_source_path_a_id(DataSource *source, size_t line_index) {
+    struct data_snapshot *snapshot = current_snapshot(source);
+    if (line_index >= snapshot->paths.count) {
+        return NULL;
+    }
+    return csv_field(source, &snapshot->paths, line_index, PATH_A, PATH_COLUMNS_COUNT);
+}
 
-        if (strcmp(given_container_id, container_a_id) == 0 ||
-            strcmp(given_container_id, container_b_id) == 0) {
-            const char *neighbor_id = strcmp(given_container_id, container_a_id) == 0 ? container_b_id : container_a_id;
-            double distance = strtod(get_path_distance(i), NULL);
+const char *data_source_path_b_id(DataSource *source, size_t line_index) {
+    struct data_snapshot *snapshot = current_snapshot(source);
+    if (line_index >= snapshot->paths.count) {
+        return NULL;
+    }
+    return csv_field(source, &snapshot->paths, line_index, PATH_B, PATH_COLUMNS_COUNT);
+}
 
-            neighbors = realloc(neighbors, (*neighbors_count + 1) * sizeof(Neighbor));
-            neighbors[*neighbors_count].id = neighbor_id;
-            neighbors[*neighbors_count].distance = distance;
-            (*neighbors_count)++;
-        }
+const char *data_source_path_distance(DataSource *source, size_t line_index) {
+    struct data_snapshot *snapshot = current_snapshot(source);
+    if (line_index >= snapshot->paths.count) {
+        return NULL;
     }
+    return csv_field(source, &snapshot->paths, line_index, PATH_DISTANCE, PATH_COLUMNS_COUNT);
+}
 
-    return neighbors; // Caller should free the memory allocated for neighbors
+bool container_matches_filters(const ContainerTable *containers, size_t row, Filters filters) {
+    bool waste_type_match = filters.waste_types == 0
+                            || (filters.waste_types & WASTE_TYPE_MASK(containers->waste_type[row])) != 0;
+
+    uint32_t capacity = containers->capacity[row];
+    bool capacity_match = ((filters.capacity_min == 0 && filters.capacity_max == 0) ||
+                           (capacity >= (uint32_t) filters.capacity_min && capacity <= (uint32_t) filters.capacity_max));
+
+    bool public_match = filters.public_filter == 0 || (filters.public_filter == 'Y') == containers->is_public[row];
+
+    return waste_type_match && capacity_match && public_match;
 }
 
-void print_containers(Filters filters) {
-    for (int i = 0; i < data_source->containers_count; i++) {
-        const char *type = data_source->containers[i][CONTAINER_WASTE_TYPE];
-        int capacity = atoi(data_source->containers[i][CONTAINER_CAPACITY]);
-        int public_value = atoi(data_source->containers[i][CONTAINER_PUBLIC]);
+void print_container_fields(const ContainerTable *containers, size_t row, const char *street, FILE *output) {
+    fprintf(output, "ID: %" PRIu64 ", Type: %s, Capacity: %" PRIu32 ", Address: %s",
+            containers->id[row], waste_type_name(containers->waste_type[row]), containers->capacity[row], street);
+    if (containers->number[row] != CONTAINER_NO_NUMBER) {
+        fprintf(output, " %" PRIu32, containers->number[row]);
+    }
+    fprintf(output, ", Neighbors: ");
+}
 
-        bool waste_type_match = false;
-        if (filters.waste_types[0] == '\0') {
-            waste_type_match = true;
-        } else {
-            for (size_t j = 0; j < filters.waste_type_count; j++) {
-                char waste_type = filters.waste_types[j][0]; // Access the first character of the waste type string
-                switch (waste_type) {
-                    case 'A':
-                        waste_type_match |= (strcmp(type, "Plastics and Aluminium") == 0);
-                        break;
-                    case 'P':
-                        waste_type_match |= (strcmp(type, "Paper") == 0);
-                        break;
-                    case 'B':
-                        waste_type_match |= (strcmp(type, "Biodegradable waste") == 0);
-                        break;
-                    case 'G':
-                        waste_type_match |= (strcmp(type, "Clear glass") == 0);
-                        break;
-                    case 'C':
-                        waste_type_match |= (strcmp(type, "Colored glass") == 0);
-                        break;
-                    case 'T':
-                        waste_type_match |= (strcmp(type, "Textile") == 0);
-                        break;
-                }
-                if (waste_type_match) {
-                    break;
-                }
+bool data_source_print_containers(DataSource *source, Filters filters, FILE *output) {
+    struct data_snapshot *snapshot = current_snapshot(source);
+    if (!lazy_tables(source, snapshot)) {
+        return false;
+    }
+    const ContainerTable *containers = &snapshot->container_table;
+    const Graph *graph = &snapshot->container_graph;
+
+    for (size_t i = 0; i < containers->count; i++) {
+        if (container_matches_filters(containers, i, filters)) {
+            // Streets skipped by the filters of the load are still in the file.
+            const char *street = containers->street[i] != CONTAINER_NO_STRING
+                                 ? string_pool_get(&containers->strings, containers->street[i])
+                                 : csv_field(source, &snapshot->containers, i, CONTAINER_STREET, CONTAINER_COLUMNS_COUNT);
+            print_container_fields(containers, i, street, output);
+            for (size_t j = graph->offsets[i]; j < graph->offsets[i + 1]; j++) {
+                fprintf(output, j > graph->offsets[i] ? " %" PRIu64 : "%" PRIu64, containers->id[graph->targets[j]]);
             }
+            fprintf(output, "\n");
         }
+    }
+    return true;
+}
 
-        bool capacity_match = ((filters.capacity_min == 0 && filters.capacity_max == 0) ||
-                               (capacity >= filters.capacity_min && capacity <= filters.capacity_max));
-
-        bool public_match = (filters.public_filter == -1 || public_value == filters.public_filter);
-
-        if (waste_type_match && capacity_match && public_match) {
-            printf("ID: ");
-            printf(data_source->containers[i][0]); // ID
-            printf(", ");
-            printf("Type: ");
-            printf(data_source->containers[i][3]); // Type
-            printf(", ");
-            printf("Capacity: ");
-            printf(data_source->containers[i][4]); // Container Capacity
-            printf(", ");
-            printf("Address: ");
-            printf(data_source->containers[i][6]); // Street
-            printf("Neighbors: ");
-            size_t neighbors_count;
-            Neighbor *neighbors = find_neighbors(data_source->containers[i][0], &neighbors_count);
-            for (size_t j = 0; j < neighbors_count; j++) {
-                printf("%s", neighbors[j].id);
-                if (j < neighbors_count - 1) {
-                    printf(" ");
-                }
-            }
-            free(neighbors);
-            printf("\n");
+bool data_source_print_stations(DataSource *source, FILE *output) {
+    struct data_snapshot *snapshot = current_snapshot(source);
+    if (!lazy_tables(source, snapshot)) {
+        return false;
+    }
+    const StationTable *stations = &snapshot->station_table;
+    const Graph *graph = &stations->graph;
+
+    for (size_t station = 0; station < stations->count; station++) {
+        char waste_types[WASTE_TYPE_COUNT + 1];
+        waste_type_mask_letters(stations->waste_types[station], waste_types);
+        fprintf(output, "%zu;%s;", station + 1, waste_types);
+        for (size_t k = graph->offsets[station]; k < graph->offsets[station + 1]; k++) {
+            fprintf(output, k > graph->offsets[station] ? ",%zu" : "%zu", graph->targets[k] + 1);
         }
+        fprintf(output, "\n");
     }
+    return true;
 }
 
-int compare_size_t(const void *a, const void *b) {
-    size_t arg1 = *(const size_t *) a;
-    size_t arg2 = *(const size_t *) b;
-    if (arg1 < arg2) return -1;
-    if (arg1 > arg2) return 1;
-    return 0;
-}
-
-void print_stations(void) {
-    Station *stations = NULL;
-    size_t stations_count = 0;
-
-    for (size_t i = 0; i < data_source->containers_count; i++) {
-        const char *container_id = get_container_id(i);
-        const char *waste_type = get_container_waste_type(i);
-        double container_x = strtod(get_container_x(i), NULL);
-        double container_y = strtod(get_container_y(i), NULL);
-
-        bool found_existing_station = false;
-        for (size_t j = 0; j < stations_count && !found_existing_station; j++) {
-            const char *station_container_id = get_container_id(stations[j].id - 1);
-            double station_container_x = strtod(get_container_x(stations[j].id - 1), NULL);
-            double station_container_y = strtod(get_container_y(stations[j].id - 1), NULL);
-
-            double x_diff = station_container_x - container_x;
-            double y_diff = station_container_y - container_y;
-            double distance = sqrt(x_diff * x_diff + y_diff * y_diff);
-
-            if (round(distance * pow(10, 14)) == 0) {
-                found_existing_station = true;
-
-                // Add waste_type to station waste_types if it's not already present
-                if (!strchr(stations[j].waste_types, waste_type[0])) {
-                    size_t len = strlen(stations[j].waste_types);
-                    stations[j].waste_types = realloc(stations[j].waste_types, len + 2);
-                    stations[j].waste_types[len] = waste_type[0];
-                    stations[j].waste_types[len + 1] = '\0';
-                }
-                // Add neighbors to the existing station
-                size_t neighbors_count;
-                Neighbor *neighbors = find_neighbors(container_id, &neighbors_count);
-                for (size_t k = 0; k < neighbors_count; k++) {
-                    const char *neighbor_id = neighbors[k].id;
-                    size_t neighbor_station_id = 0;
-                    for (size_t l = 0; l < stations_count; l++) {
-                        if (strcmp(get_container_id(stations[l].id - 1), neighbor_id) == 0) {
-                            neighbor_station_id = stations[l].id;
-                            break;
-                        }
-                    }
-                    if (neighbor_station_id > 0) {
-                        bool already_added = false;
-                        for (size_t l = 0; l < stations[j].neighbors_count; l++) {
-                            if (stations[j].neighbors[l] == neighbor_station_id) {
-                                already_added = true;
-                                break;
-                            }
-                        }
-                        if (!already_added) {
-                            stations[j].neighbors = realloc(stations[j].neighbors,
-                                                            (stations[j].neighbors_count + 1) * sizeof(size_t));
-                            stations[j].neighbors[stations[j].neighbors_count] = neighbor_station_id;
-                            stations[j].neighbors_count++;
-                        }
-                    }
-                }
-                free(neighbors);
-            }
-        }
-        if (!found_existing_station) {
-            // Create a new station
-            stations_count++;
-            stations = realloc(stations, stations_count * sizeof(Station));
-            Station *new_station = &stations[stations_count - 1];
-            new_station->id = stations_count;
-            new_station->waste_types = malloc(2 * sizeof(char));
-            new_station->waste_types[0] = waste_type[0];
-            new_station->waste_types[1] = '\0';
-            new_station->neighbors_count = 0;
-            new_station->neighbors = NULL;
-
-            // Add neighbors to the new station
-            size_t neighbors_count;
-            Neighbor *neighbors = find_neighbors(container_id, &neighbors_count);
-            for (size_t k = 0; k < neighbors_count; k++) {
-                const char *neighbor_id = neighbors[k].id;
-                size_t neighbor_station_id = 0;
-                for (size_t l = 0; l < stations_count - 1; l++) {
-                    if (strcmp(get_container_id(stations[l].id - 1), neighbor_id) == 0) {
-                        neighbor_station_id = stations[l].id;
-                        break;
-                    }
-                }
-
-                if (neighbor_station_id > 0) {
-                    new_station->neighbors = realloc(new_station->neighbors,
-                                                     (new_station->neighbors_count + 1) * sizeof(size_t));
-                    new_station->neighbors[new_station->neighbors_count] = neighbor_station_id;
-                    new_station->neighbors_count++;
-
-                    // Add the new station as a neighbor to the existing station
-                    Station *neighbor_station = &stations[neighbor_station_id - 1];
-                    neighbor_station->neighbors = realloc(neighbor_station->neighbors,
-                                                          (neighbor_station->neighbors_count + 1) * sizeof(size_t));
-                    neighbor_station->neighbors[neighbor_station->neighbors_count] = new_station->id;
-                    neighbor_station->neighbors_count++;
-                }
-            }
-            free(neighbors);
+bool data_source_print_route(DataSource *source, size_t from, size_t to, const RouteOptions *options, FILE *output) {
+    struct data_snapshot *snapshot = current_snapshot(source);
+    if (!lazy_tables(source, snapshot)) {
+        return false;
+    }
+    const StationTable *stations = &snapshot->station_table;
+    assert(from >= 1 && from <= stations->count && to >= 1 && to <= stations->count);
+
+    RouteOptions route_options = *options;
+    if (route_options.algorithm == ROUTE_CONTRACTION_HIERARCHY && route_options.hierarchy == NULL) {
+        route_options.hierarchy = data_source_station_hierarchy(source);
+        if (route_options.hierarchy == NULL) {
+            return false;
         }
     }
-    // Print stations
-    for (size_t i = 0; i < stations_count; i++) {
-        printf("%zu;%s;", stations[i].id, stations[i].waste_types);
-        qsort(stations[i].neighbors, stations[i].neighbors_count, sizeof(size_t), compare_size_t);
-        for (size_t j = 0; j < stations[i].neighbors_count; j++) {
-            printf("%zu", stations[i].neighbors[j]);
-            if (j < stations[i].neighbors_count - 1) {
-                printf(",");
-            }
+    if (route_options.algorithm == ROUTE_LANDMARKS && route_options.landmarks == NULL) {
+        route_options.landmarks = data_source_station_landmarks(source);
+        if (route_options.landmarks == NULL) {
+            return false;
         }
-        printf("\n");
     }
-    // Free memory
-    for (size_t i = 0; i < stations_count; i++) {
-        free(stations[i].waste_types);
-        free(stations[i].neighbors);
+
+    Route route;
+    bool found;
+    if (!route_find(&stations->graph, from - 1, to - 1, &route_options, &route, &found)) {
+        return false;
+    }
+
+    if (!found) {
+        fprintf(output, "No path between specified sites\n");
+        return true;
     }
-    free(stations);
+    for (size_t index = 0; index < route.count; index++) {
+        fprintf(output, index > 0 ? "-%zu" : "%zu", route.nodes[index] + 1);
+    }
+    fprintf(output, " %" PRIu64 "\n", route.distance);
+
+    route_destroy(&route);
+    return true;
+}
+
+bool init_data_source(const char *containers_path, const char *paths_path) {
+    default_source = data_source_open(containers_path, paths_path);
+    return default_source != NULL;
 }
 
+bool init_data_source_lazy(const char *containers_path, const char *paths_path) {
+    DataSourceOptions options = { NULL, NULL, CONTAINER_COLUMNS_ALL, true, false };
+    default_source = data_source_open_with(containers_path, paths_path, &options);
+    return default_source != NULL;
+}
+
+void destroy_data_source(void) {
+    data_source_close(default_source);
+    default_source = NULL;
+}
+
+const ContainerTable *get_container_table(void) {
+    return data_source_container_table(default_source);
+}
+
+const PathTable *get_path_table(void) {
+    return data_source_path_table(default_source);
+}
+
+const Graph *get_container_graph(void) {
+    return data_source_container_graph(default_source);
+}
+
+const StationTable *get_station_table(void) {
+    return data_source_station_table(default_source);
+}
+
+const ContractionHierarchy *get_station_hierarchy(void) {
+    return data_source_station_hierarchy(default_source);
+}
+
+const Landmarks *get_station_landmarks(void) {
+    return data_source_station_landmarks(default_source);
+}
+
+bool find_container_by_id(uint64_t id, size_t *line_index) {
+    return data_source_find_container(default_source, id, line_index);
+}
+
+const char *get_container_id(size_t line_index) {
+    return data_source_container_id(default_source, line_index);
+}
+
+const char *get_container_x(size_t line_index) {
+    return data_source_container_x(default_source, line_index);
+}
+
+const char *get_container_y(size_t line_index) {
+    return data_source_container_y(default_source, line_index);
+}
+
+const char *get_container_waste_type(size_t line_index) {
+    return data_source_container_waste_type(default_source, line_index);
+}
+
+const char *get_container_capacity(size_t line_index) {
+    return data_source_container_capacity(default_source, line_index);
+}
+
+const char *get_container_name(size_t line_index) {
+    return data_source_container_name(default_source, line_index);
+}
+
+const char *get_container_street(size_t line_index) {
+    return data_source_container_street(default_source, line_index);
+}
+
+const char *get_container_number(size_t line_index) {
+    return data_source_container_number(default_source, line_index);
+}
+
+const char *get_container_public(size_t line_index) {
+    return data_source_container_public(default_source, line_index);
+}
+
+const char *get_path_a_id(size_t line_index) {
+    return data_source_path_a_id(default_source, line_index);
+}
+
+const char *get_path_b_id(size_t line_index) {
+    return data_source_path_b_id(default_source, line_index);
+}
+
+const char *get_path_distance(size_t line_index) {
+    return data_source_path_distance(default_source, line_index);
+}
+
+bool print_containers(Filters filters, FILE *output) {
+    return data_source_print_containers(default_source, filters, output);
+}
+
+bool print_stations(FILE *output) {
+    return data_source_print_stations(default_source, output);
+}
+
+bool print_route(size_t from, size_t to, const RouteOptions *options, FILE *output) {
+    return data_source_print_route(default_source, from, to, options, output);
+}
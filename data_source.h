@@ -2,7 +2,19 @@
 #define DATA_SOURCE_H
 
 #include <stdbool.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include "container.h"
+#include "graph.h"
+#include "path.h"
+#include "route.h"
+#include "station.h"
+
+/*
+ * The functions without a DataSource handle work on a single data source
+ * opened by init_data_source(). The data_source_* functions at the end of
+ * this file do the same for any number of data sources open at once.
+ */
 
 /**
  * @brief Initializes internal data storage.
@@ -12,9 +24,14 @@
  * function before any of the following. Otherwise, their behavior is undefined
  * and probably ends with SIGSEGV.
  * 
- * @note The only validation of input files within this function is
- * the counting of columns of the input CSV files. It basically counts ','
- * in each line. Any other validation of the data is up to you ;)
+ * @note Besides the counting of columns of the input CSV files, every field
+ * is converted to the typed tables returned by get_container_table() and
+ * get_path_table(). A field that does not match the assignment (an ID that
+ * is not a number, waste type "Oil", ...) makes the whole file invalid.
+ *
+ * @note Regular files are memory-mapped and their fields are terminated
+ * in place, so the strings returned by get_* point into the mapping.
+ * Other files (pipes, ...) are read into memory first.
  * 
  * @warning This function allocates memory. To avoid memory leaks is necessary
  * to call destroy_data_source() before ending the program.
@@ -25,8 +42,8 @@
  * 
  * @retval true if no error occurs.
  * 
- * @retval false in case of error, i.e., memory failure, inaccessible input file
- * or unexpected count of columns.
+ * @retval false in case of error, i.e., memory failure, inaccessible input file,
+ * unexpected count of columns or an invalid field.
  */
 bool init_data_source(const char *containers_path, const char *paths_path);
 
@@ -40,6 +57,20 @@ bool init_data_source(const char *containers_path, const char *paths_path);
  */
 void destroy_data_source(void);
 
+/**
+ * @brief Same as init_data_source(), but the rows of the input files are
+ * only split when the get_* functions first ask for one of their fields.
+ *
+ * Opening costs little more than finding the lines of the files, so looking
+ * up a few containers does not pay for the rest of them. The files are not
+ * validated until a typed table is needed, get_* returns NULL for the fields
+ * of an invalid row instead. See data_source_open_with() with the lazy option.
+ *
+ * @retval true if both files could be read.
+ * @retval false on memory failure or an inaccessible input file.
+ */
+bool init_data_source_lazy(const char *containers_path, const char *paths_path);
+
 /**
  * @brief Selects the container ID from the currently loaded CSV in data storage.
  * 
@@ -172,21 +203,340 @@ const char *get_path_b_id(size_t line_index);
  */
 const char *get_path_distance(size_t line_index);
 
+/**
+ * @brief Returns the containers converted to typed columns.
+ *
+ * The table is built once by init_data_source(), which fails if any field
+ * of the containers file cannot be converted.
+ */
+const ContainerTable *get_container_table(void);
+
+/**
+ * @brief Returns the paths converted to typed columns.
+ *
+ * The table is built once by init_data_source(), which fails if any field
+ * of the paths file cannot be converted.
+ */
+const PathTable *get_path_table(void);
+
+/**
+ * @brief Returns the graph of containers connected by paths.
+ *
+ * Nodes are the lines of the containers file. Every path is present in both
+ * directions and only once, neighbors of a container are sorted by their IDs.
+ */
+const Graph *get_container_graph(void);
+
+/**
+ * @brief Returns the stations of the loaded containers.
+ *
+ * Containers at the same coordinates form a station, stations are numbered
+ * from 0 in the order of their first container in the containers file.
+ * Stations are neighbors when a path connects their containers.
+ */
+const StationTable *get_station_table(void);
+
+/**
+ * @brief Returns the contraction hierarchy of the station graph.
+ *
+ * Tables mapped from a snapshot file or shared memory bring the hierarchy
+ * along. Otherwise it is built on the first call, which costs more than a
+ * few route searches, and kept until destroy_data_source(). Threads calling
+ * it at the same time wait for the one that builds it.
+ *
+ * @retval NULL if the memory for the hierarchy cannot be allocated.
+ */
+const ContractionHierarchy *get_station_hierarchy(void);
+
+/**
+ * @brief Returns the landmarks of the station graph used to guide A* route searches.
+ *
+ * The landmarks are picked and measured on the first call and kept until
+ * destroy_data_source(). Threads calling it at the same time wait for the one
+ * that builds them.
+ *
+ * @retval NULL if the memory for the landmarks cannot be allocated.
+ */
+const Landmarks *get_station_landmarks(void);
+
+/**
+ * @brief Finds the line of the container with the given ID.
+ *
+ * The lookup goes through a hash index built by init_data_source(), which
+ * also fails if the containers file repeats an ID or the paths file refers
+ * to an ID that is not in the containers file.
+ *
+ * @param id ID of the wanted container.
+ * @param line_index Receives the number of the line of the container (starts from 0).
+ * @retval true if the container exists.
+ * @retval false otherwise, line_index is left untouched.
+ */
+bool find_container_by_id(uint64_t id, size_t *line_index);
+
 typedef struct {
-    char waste_types[8][2];
-    size_t waste_type_count;
+    WasteTypeMask waste_types;
     int capacity_min;
     int capacity_max;
     int public_filter;
     const char *containers_path;
     const char *paths_path;
     int special_flag;
+    int route_flag;
+    size_t route_from;
+    size_t route_to;
+    RouteOptions route_options;
+    const char *batch_path;
+    const char *socket_path;
+    const char *snapshot_path;
+    int preload_flag;
+    int stream_flag;
+    int unpublish_flag;
 } Filters;
 
 
-// Update the function prototype
-void print_containers(Filters filters);
+// Prints the containers passing the filters. Returns false if the tables of a lazily
+// loaded data source cannot be built, see init_data_source_lazy().
+bool print_containers(Filters filters, FILE *output);
+
+// Tells whether the container at the row passes the -t, -c and -p filters.
+bool container_matches_filters(const ContainerTable *containers, size_t row, Filters filters);
+
+// Prints the container at the row with the street as listed by print_containers(), up to its neighbors.
+void print_container_fields(const ContainerTable *containers, size_t row, const char *street, FILE *output);
 void print_locations(void);
-void print_stations(void);
+// Prints the stations and their neighbors. Returns false like print_containers().
+bool print_stations(FILE *output);
+
+// Prints the shortest path between the stations with the IDs from and to (starting from 1),
+// which must be below the station count plus one. Returns false on allocation failure or
+// like print_containers().
+bool print_route(size_t from, size_t to, const RouteOptions *options, FILE *output);
+
+/**
+ * @brief Loaded input files that can be queried from several threads.
+ *
+ * Every DataSource holds its own snapshot of the files, so several of them,
+ * e.g., one per district, can be open and queried at the same time.
+ */
+typedef struct DataSource DataSource;
+
+/**
+ * @brief Loads the input files into a new data source.
+ *
+ * Same as init_data_source(), the paths are kept for data_source_reload()
+ * and must stay valid until data_source_close().
+ *
+ * @retval DataSource* the new data source.
+ * @retval NULL in case of the errors of init_data_source().
+ */
+DataSource *data_source_open(const char *containers_path, const char *paths_path);
+
+/**
+ * @brief Same as data_source_open(), but maps the tables from a snapshot file
+ * when it was written from the input files as they are now.
+ *
+ * Tables published by data_source_publish_shared() take precedence over the
+ * snapshot file, data_source_open() maps them as well.
+ *
+ * The input files are not parsed then. The snapshot file is tried again on
+ * every data_source_reload(), so the path must stay valid as well. A missing
+ * or stale snapshot file, or one holding indices out of range, is ignored and
+ * the input files are loaded. Its checksum is only verified with the
+ * verify_snapshot option of data_source_open_with().
+ *
+ * @param snapshot_path path of the snapshot file, NULL to always load the input files.
+ * @retval DataSource* the new data source.
+ * @retval NULL in case of the errors of init_data_source().
+ */
+DataSource *data_source_open_snapshot(const char *containers_path, const char *paths_path,
+                                      const char *snapshot_path);
+
+/**
+ * @brief Tells whether the published snapshot was mapped from a snapshot file.
+ */
+bool data_source_snapshot_mapped(DataSource *source);
+
+/**
+ * @brief Writes the tables of the published snapshot to a snapshot file that
+ * data_source_open_snapshot() can map instead of loading the input files.
+ *
+ * The file is replaced atomically and is tied to the size and modification
+ * time of both input files, so it stops being used once either changes.
+ * The contraction hierarchy of the stations is built first if needed and
+ * saved as well, so route queries mapping the file do not build it again.
+ *
+ * @retval true if the snapshot file was written.
+ * @retval false on I/O errors or allocation failure, if the input files could
+ * not be examined or if the data source was opened with filters.
+ */
+bool data_source_write_snapshot(DataSource *source, const char *snapshot_path);
+
+/**
+ * @brief Publishes the tables of the published snapshot to a POSIX shared
+ * memory object, which every later data_source_open() of the same input
+ * files maps read-only instead of loading them.
+ *
+ * The contraction hierarchy is published along, as by
+ * data_source_write_snapshot().
+ *
+ * The object outlives the process and is named after the input files. Only
+ * the processes of the same user map it, and it is ignored once either input
+ * file changes, until it is published again.
+ *
+ * @retval true if the tables were published.
+ * @retval false if shared memory is not available, on allocation failure, if
+ * the input files could not be examined or the data source was opened with
+ * filters.
+ */
+bool data_source_publish_shared(DataSource *source);
+
+/**
+ * @brief Removes the shared memory object published for the input files.
+ * Processes that mapped it keep using it.
+ *
+ * @retval true if there was one.
+ */
+bool data_source_remove_shared(DataSource *source);
+
+/**
+ * @brief Same as data_source_remove_shared() without loading the input files.
+ *
+ * @retval true if there was one.
+ */
+bool data_source_remove_shared_files(const char *containers_path, const char *paths_path);
+
+/**
+ * @brief Ways of loading a data source, see data_source_open_with().
+ */
+typedef struct DataSourceOptions {
+    // Snapshot file to map instead of loading the input files, see
+    // data_source_open_snapshot(), or NULL.
+    const char *snapshot_path;
+    // Filters of the only listing the data source is opened for, or NULL.
+    const Filters *filters;
+    // Container columns to store, CONTAINER_COLUMNS_ALL for any query.
+    ContainerColumns columns;
+    // Split the rows of the files only once their fields are asked for.
+    bool lazy;
+    // Verify the checksum of a snapshot file or shared memory object before using it,
+    // which reads all of it. Otherwise only its header and the indices it holds are checked.
+    bool verify_snapshot;
+} DataSourceOptions;
+
+// Container columns used by listings.
+#define DATA_SOURCE_LISTING_COLUMNS (CONTAINER_COLUMN_ID | CONTAINER_COLUMN_WASTE_TYPE | CONTAINER_COLUMN_CAPACITY \
+                                     | CONTAINER_COLUMN_STREET | CONTAINER_COLUMN_NUMBER | CONTAINER_COLUMN_PUBLIC)
+
+// Container columns used by stations and routes.
+#define DATA_SOURCE_STATION_COLUMNS (CONTAINER_COLUMN_ID | CONTAINER_COLUMN_X | CONTAINER_COLUMN_Y \
+                                     | CONTAINER_COLUMN_WASTE_TYPE | CONTAINER_COLUMN_CAPACITY)
+
+/**
+ * @brief Same as data_source_open(), with the options.
+ *
+ * With filters, the names and streets of the containers that do not pass
+ * them are not stored, which saves most of the work of a selective listing.
+ * Such a data source answers every query.
+ *
+ * Columns left out of the mask are validated but not stored, so queries
+ * needing them must not be made. Without DATA_SOURCE_STATION_COLUMNS, the
+ * station table is empty.
+ *
+ * A lazy data source only finds the lines of the input files when opened,
+ * and splits a row on the first access to one of its fields, so opening it
+ * costs little more than reading the files. The field accessors,
+ * data_source_container_id() and the like, return NULL for the fields of an
+ * invalid row. data_source_find_container() indexes the IDs at the starts of
+ * the lines on its first call, and does not find an ID starting several
+ * lines nor the container of an invalid row. The typed tables, and the
+ * listings and routes using them, split and validate every row on their
+ * first use. If the files are invalid, the tables stay empty and the print
+ * functions return false.
+ *
+ * A data source opened with filters, without some columns or lazily cannot
+ * be written to a snapshot file nor published to shared memory. The filters
+ * are copied.
+ *
+ * @retval DataSource* the new data source.
+ * @retval NULL in case of the errors of init_data_source().
+ */
+DataSource *data_source_open_with(const char *containers_path, const char *paths_path,
+                                  const DataSourceOptions *options);
+
+/**
+ * @brief Frees the data source. A snapshot still pinned by another thread is
+ * freed by its last data_source_unpin(). Passing NULL does nothing.
+ */
+void data_source_close(DataSource *source);
+
+/**
+ * @brief Loads the input files again and publishes them as a new snapshot.
+ *
+ * The new snapshot is built while queries keep running on the published one,
+ * which stays alive until the last thread pinning it calls
+ * data_source_unpin(). If loading fails, the published snapshot is kept.
+ *
+ * @note The strings returned by the accessors may point into a memory mapping
+ * of the files, so a feed should replace the files by renaming new ones over
+ * them rather than rewriting them in place.
+ *
+ * @retval true if the new snapshot was published.
+ * @retval false if the files could not be loaded.
+ */
+bool data_source_reload(DataSource *source);
+
+/**
+ * @brief Tells whether an input file was replaced or modified since the last
+ * load or reload attempt, judging by its inode, size and modification time.
+ */
+bool data_source_changed(DataSource *source);
+
+/**
+ * @brief Pins the published snapshot of the data source for the calling thread.
+ *
+ * Until data_source_unpin(), every accessor of the data source called by the
+ * thread uses the pinned snapshot, even if data_source_reload() publishes
+ * another. Threads that query while reloads may happen must pin around every
+ * query. Pins of the same data source do not nest.
+ */
+void data_source_pin(DataSource *source);
+
+/**
+ * @brief Releases the snapshot pinned by the calling thread, freeing it if it
+ * is no longer published nor pinned by another thread.
+ */
+void data_source_unpin(DataSource *source);
+
+/**
+ * @brief Returns the version of the snapshot in use, 1 for the one loaded by
+ * data_source_open() and one more for every successful reload.
+ */
+unsigned long data_source_version(DataSource *source);
+
+// Same as the get_* functions above for the given data source.
+const char *data_source_container_id(DataSource *source, size_t line_index);
+const char *data_source_container_x(DataSource *source, size_t line_index);
+const char *data_source_container_y(DataSource *source, size_t line_index);
+const char *data_source_container_waste_type(DataSource *source, size_t line_index);
+const char *data_source_container_capacity(DataSource *source, size_t line_index);
+const char *data_source_container_name(DataSource *source, size_t line_index);
+const char *data_source_container_street(DataSource *source, size_t line_index);
+const char *data_source_container_number(DataSource *source, size_t line_index);
+const char *data_source_container_public(DataSource *source, size_t line_index);
+const char *data_source_path_a_id(DataSource *source, size_t line_index);
+const char *data_source_path_b_id(DataSource *source, size_t line_index);
+const char *data_source_path_distance(DataSource *source, size_t line_index);
+const ContainerTable *data_source_container_table(DataSource *source);
+const PathTable *data_source_path_table(DataSource *source);
+const Graph *data_source_container_graph(DataSource *source);
+const StationTable *data_source_station_table(DataSource *source);
+const ContractionHierarchy *data_source_station_hierarchy(DataSource *source);
+const Landmarks *data_source_station_landmarks(DataSource *source);
+bool data_source_find_container(DataSource *source, uint64_t id, size_t *line_index);
+
+// Same as the print_* functions above for the given data source.
+bool data_source_print_containers(DataSource *source, Filters filters, FILE *output);
+bool data_source_print_stations(DataSource *source, FILE *output);
+bool data_source_print_route(DataSource *source, size_t from, size_t to, const RouteOptions *options, FILE *output);
 
 #endif // DATA_SOURCE_H
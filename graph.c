@@ -0,0 +1,128 @@
+#include "graph.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Directed half of an edge while the graph is being built.
+struct graph_arc {
+    size_t source;
+    size_t target;
+    uint32_t weight;
+};
+
+static size_t rank_of(const size_t *rank, size_t node) {
+    return rank != NULL ? rank[node] : node;
+}
+
+// Stable counting sort of arcs by key, the keys are below key_count.
+static bool sort_arcs(struct graph_arc *arcs, struct graph_arc *sorted, size_t arc_count, size_t key_count,
+                      const size_t *rank, bool by_source) {
+    size_t *starts = calloc(key_count + 1, sizeof(size_t));
+    if (starts == NULL) {
+        return false;
+    }
+
+    for (size_t index = 0; index < arc_count; index++) {
+        size_t key = by_source ? arcs[index].source : rank_of(rank, arcs[index].target);
+        starts[key + 1]++;
+    }
+    for (size_t key = 0; key < key_count; key++) {
+        starts[key + 1] += starts[key];
+    }
+    for (size_t index = 0; index < arc_count; index++) {
+        size_t key = by_source ? arcs[index].source : rank_of(rank, arcs[index].target);
+        sorted[starts[key]++] = arcs[index];
+    }
+
+    free(starts);
+    return true;
+}
+
+bool graph_build(Graph *graph, size_t node_count, const GraphEdges *edges, const size_t *rank) {
+    assert(graph != NULL && edges != NULL);
+
+    memset(graph, 0, sizeof(*graph));
+    graph->node_count = node_count;
+
+    size_t arc_count = 0;
+    struct graph_arc *arcs = malloc((edges->count * 2 + 1) * sizeof(struct graph_arc));
+    struct graph_arc *sorted = malloc((edges->count * 2 + 1) * sizeof(struct graph_arc));
+    graph->offsets = calloc(node_count + 1, sizeof(size_t));
+    if (arcs == NULL || sorted == NULL || graph->offsets == NULL) {
+        free(arcs);
+        free(sorted);
+        graph_destroy(graph);
+        return false;
+    }
+
+    for (size_t index = 0; index < edges->count; index++) {
+        size_t a = edges->a[index];
+        size_t b = edges->b[index];
+        assert(a < node_count && b < node_count);
+
+        if (a != b) {
+            arcs[arc_count++] = (struct graph_arc) { a, b, edges->weights[index] };
+            arcs[arc_count++] = (struct graph_arc) { b, a, edges->weights[index] };
+        }
+    }
+
+    // Sorting by neighbor and then stably by source leaves every adjacency
+    // list in neighbor order, with repeated arcs next to each other.
+    if (!sort_arcs(arcs, sorted, arc_count, node_count, rank, false)
+        || !sort_arcs(sorted, arcs, arc_count, node_count, NULL, true)) {
+        free(arcs);
+        free(sorted);
+        graph_destroy(graph);
+        return false;
+    }
+    free(sorted);
+
+    size_t unique_count = 0;
+    for (size_t index = 0; index < arc_count; index++) {
+        struct graph_arc *last = unique_count > 0 ? &arcs[unique_count - 1] : NULL;
+
+        if (last != NULL && last->source == arcs[index].source && last->target == arcs[index].target) {
+            if (arcs[index].weight < last->weight) {
+                last->weight = arcs[index].weight;
+            }
+        } else {
+            arcs[unique_count++] = arcs[index];
+        }
+    }
+
+    graph->targets = malloc((unique_count + 1) * sizeof(size_t));
+    graph->weights = malloc((unique_count + 1) * sizeof(uint32_t));
+    if (graph->targets == NULL || graph->weights == NULL) {
+        free(arcs);
+        graph_destroy(graph);
+        return false;
+    }
+
+    for (size_t index = 0; index < unique_count; index++) {
+        graph->offsets[arcs[index].source + 1]++;
+        graph->targets[index] = arcs[index].target;
+        graph->weights[index] = arcs[index].weight;
+    }
+    for (size_t node = 0; node < node_count; node++) {
+        graph->offsets[node + 1] += graph->offsets[node];
+    }
+
+    free(arcs);
+    return true;
+}
+
+size_t graph_degree(const Graph *graph, size_t node) {
+    assert(graph != NULL && node < graph->node_count);
+
+    return graph->offsets[node + 1] - graph->offsets[node];
+}
+
+void graph_destroy(Graph *graph) {
+    assert(graph != NULL);
+
+    free(graph->offsets);
+    free(graph->targets);
+    free(graph->weights);
+    memset(graph, 0, sizeof(*graph));
+}
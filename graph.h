@@ -0,0 +1,37 @@
+#ifndef GRAPH_H
+#define GRAPH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Undirected weighted graph in compressed sparse row form. The neighbors of node u are
+// targets[offsets[u]] up to targets[offsets[u + 1] - 1], with weights at the same positions.
+typedef struct Graph {
+    size_t node_count;
+    size_t *offsets;
+    size_t *targets;
+    uint32_t *weights;
+} Graph;
+
+// Edges given as three parallel arrays, each edge connects both of its nodes.
+typedef struct GraphEdges {
+    size_t count;
+    const size_t *a;
+    const size_t *b;
+    const uint32_t *weights;
+} GraphEdges;
+
+// Builds the graph of node_count nodes from the edges. Edges are symmetrized, loops are
+// dropped and repeated edges are kept once with the smallest weight. The neighbors of every
+// node are sorted by rank[neighbor], or by the neighbor itself when rank is NULL; rank must
+// be a permutation of the nodes. Returns false on allocation failure.
+bool graph_build(Graph *graph, size_t node_count, const GraphEdges *edges, const size_t *rank);
+
+// Returns the number of neighbors of the node.
+size_t graph_degree(const Graph *graph, size_t node);
+
+// Frees the memory of the graph.
+void graph_destroy(Graph *graph);
+
+#endif // GRAPH_H
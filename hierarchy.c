@@ -0,0 +1,623 @@
+#include "hierarchy.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Witness searches give up after settling this many nodes and add the shortcut. Estimating
+// the shortcuts of a node for its priority uses much shorter searches.
+#define HIERARCHY_WITNESS_SETTLE_LIMIT 500
+#define HIERARCHY_ESTIMATE_SETTLE_LIMIT 10
+#define HIERARCHY_ESTIMATE_HOP_LIMIT 5
+
+// Edge of the graph being contracted, stored at both of its nodes.
+struct hierarchy_arc {
+    size_t target;
+    uint64_t weight;
+    size_t middle;
+};
+
+struct hierarchy_arcs {
+    struct hierarchy_arc *arcs;
+    size_t count;
+    size_t capacity;
+};
+
+// Binary heap with repeated entries, outdated ones are skipped by their users.
+struct hierarchy_heap_entry {
+    uint64_t key;
+    size_t node;
+};
+
+struct hierarchy_heap {
+    struct hierarchy_heap_entry *entries;
+    size_t count;
+    size_t capacity;
+};
+
+struct hierarchy_builder {
+    size_t node_count;
+    struct hierarchy_arcs *adjacency;
+    bool *contracted;
+    // Length of the longest chain of contracted nodes below each node
+    size_t *level;
+    uint64_t *priority;
+    struct hierarchy_heap order;
+
+    // Scratch space of the witness searches
+    uint64_t *distances;
+    size_t *hops;
+    size_t *touched;
+    size_t touched_count;
+    struct hierarchy_heap witness;
+    struct hierarchy_arc *neighbors;
+    bool *is_target;
+    uint64_t *target_limits;
+};
+
+static bool heap_push(struct hierarchy_heap *heap, uint64_t key, size_t node) {
+    if (heap->count == heap->capacity) {
+        size_t capacity = heap->capacity > 0 ? heap->capacity * 2 : 64;
+        struct hierarchy_heap_entry *entries = realloc(heap->entries, capacity * sizeof(*entries));
+        if (entries == NULL) {
+            return false;
+        }
+        heap->entries = entries;
+        heap->capacity = capacity;
+    }
+
+    size_t index = heap->count++;
+    while (index > 0 && heap->entries[(index - 1) / 2].key > key) {
+        heap->entries[index] = heap->entries[(index - 1) / 2];
+        index = (index - 1) / 2;
+    }
+    heap->entries[index] = (struct hierarchy_heap_entry) { key, node };
+
+    return true;
+}
+
+static struct hierarchy_heap_entry heap_pop(struct hierarchy_heap *heap) {
+    assert(heap->count > 0);
+
+    struct hierarchy_heap_entry top = heap->entries[0];
+    struct hierarchy_heap_entry last = heap->entries[--heap->count];
+    size_t index = 0;
+    size_t child;
+
+    while ((child = 2 * index + 1) < heap->count) {
+        if (child + 1 < heap->count && heap->entries[child + 1].key < heap->entries[child].key) {
+            child++;
+        }
+        if (heap->entries[child].key >= last.key) {
+            break;
+        }
+        heap->entries[index] = heap->entries[child];
+        index = child;
+    }
+    if (heap->count > 0) {
+        heap->entries[index] = last;
+    }
+
+    return top;
+}
+
+static bool add_arc(struct hierarchy_arcs *arcs, struct hierarchy_arc arc) {
+    if (arcs->count == arcs->capacity) {
+        size_t capacity = arcs->capacity > 0 ? arcs->capacity * 2 : 4;
+        struct hierarchy_arc *grown = realloc(arcs->arcs, capacity * sizeof(*grown));
+        if (grown == NULL) {
+            return false;
+        }
+        arcs->arcs = grown;
+        arcs->capacity = capacity;
+    }
+    arcs->arcs[arcs->count++] = arc;
+    return true;
+}
+
+// Removes the arc to the target, the order of arcs is not kept.
+static void remove_arc(struct hierarchy_arcs *arcs, size_t target) {
+    for (size_t index = 0; index < arcs->count; index++) {
+        if (arcs->arcs[index].target == target) {
+            arcs->arcs[index] = arcs->arcs[--arcs->count];
+            return;
+        }
+    }
+}
+
+// Connects a and b through middle, or shortens their edge if they are connected already.
+static bool add_shortcut(struct hierarchy_builder *builder, size_t a, size_t b, uint64_t weight, size_t middle) {
+    struct hierarchy_arcs *arcs = &builder->adjacency[a];
+
+    for (size_t index = 0; index < arcs->count; index++) {
+        if (arcs->arcs[index].target == b) {
+            if (weight < arcs->arcs[index].weight) {
+                struct hierarchy_arcs *back = &builder->adjacency[b];
+                for (size_t k = 0; k < back->count; k++) {
+                    if (back->arcs[k].target == a) {
+                        back->arcs[k].weight = weight;
+                        back->arcs[k].middle = middle;
+                    }
+                }
+                arcs->arcs[index].weight = weight;
+                arcs->arcs[index].middle = middle;
+            }
+            return true;
+        }
+    }
+
+    return add_arc(&builder->adjacency[a], (struct hierarchy_arc) { b, weight, middle })
+           && add_arc(&builder->adjacency[b], (struct hierarchy_arc) { a, weight, middle });
+}
+
+/*
+ * Dijkstra's algorithm from source among the nodes not contracted yet,
+ * avoiding excluded and paths of more than hop_limit edges. A marked target
+ * is done once it is settled or reached within its target_limits entry, the
+ * search stops when all are done, past limit or after settling settle_limit
+ * nodes. The distances it leaves are upper bounds of the real ones.
+ */
+static bool witness_search(struct hierarchy_builder *builder, size_t source, size_t excluded, uint64_t limit,
+                           size_t target_count, size_t hop_limit, size_t settle_limit) {
+    for (size_t index = 0; index < builder->touched_count; index++) {
+        builder->distances[builder->touched[index]] = UINT64_MAX;
+    }
+    builder->touched_count = 0;
+    builder->witness.count = 0;
+
+    builder->distances[source] = 0;
+    builder->hops[source] = 0;
+    builder->touched[builder->touched_count++] = source;
+    if (!heap_push(&builder->witness, 0, source)) {
+        return false;
+    }
+
+    size_t settled = 0;
+    while (builder->witness.count > 0 && settled < settle_limit && target_count > 0) {
+        struct hierarchy_heap_entry entry = heap_pop(&builder->witness);
+        if (entry.key > builder->distances[entry.node]) {
+            continue;
+        }
+        if (entry.key > limit) {
+            break;
+        }
+        settled++;
+        if (builder->is_target[entry.node]) {
+            builder->is_target[entry.node] = false;
+            target_count--;
+        }
+        if (builder->hops[entry.node] == hop_limit) {
+            continue;
+        }
+
+        // Contracted nodes are removed from the edges of their neighbors, so none is reached.
+        const struct hierarchy_arcs *arcs = &builder->adjacency[entry.node];
+        for (size_t index = 0; index < arcs->count; index++) {
+            size_t target = arcs->arcs[index].target;
+            uint64_t distance = entry.key + arcs->arcs[index].weight;
+
+            if (target == excluded || distance > limit || distance >= builder->distances[target]) {
+                continue;
+            }
+            if (builder->distances[target] == UINT64_MAX) {
+                builder->touched[builder->touched_count++] = target;
+            }
+            builder->distances[target] = distance;
+            builder->hops[target] = builder->hops[entry.node] + 1;
+            // A path no longer than the one through the contracted node is a witness already.
+            if (builder->is_target[target] && distance <= builder->target_limits[target]) {
+                builder->is_target[target] = false;
+                if (--target_count == 0) {
+                    break;
+                }
+            }
+            if (!heap_push(&builder->witness, distance, target)) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+/*
+ * Finds the shortcuts needed to contract the node: a pair of its neighbors
+ * needs one unless a witness path avoiding the node is as short. Only counts
+ * them when simulating, otherwise adds them.
+ */
+static bool contract_node(struct hierarchy_builder *builder, size_t node, bool simulate, size_t *shortcut_count,
+                          size_t *neighbor_count) {
+    const struct hierarchy_arcs *arcs = &builder->adjacency[node];
+    size_t count = 0;
+
+    for (size_t index = 0; index < arcs->count; index++) {
+        if (!builder->contracted[arcs->arcs[index].target]) {
+            builder->neighbors[count++] = arcs->arcs[index];
+        }
+    }
+    *shortcut_count = 0;
+    *neighbor_count = count;
+
+    for (size_t from = 0; from + 1 < count; from++) {
+        uint64_t from_weight = builder->neighbors[from].weight;
+        uint64_t longest = 0;
+        for (size_t to = from + 1; to < count; to++) {
+            size_t target = builder->neighbors[to].target;
+            builder->is_target[target] = true;
+            builder->target_limits[target] = from_weight + builder->neighbors[to].weight;
+            if (builder->neighbors[to].weight > longest) {
+                longest = builder->neighbors[to].weight;
+            }
+        }
+        bool searched = witness_search(builder, builder->neighbors[from].target, node, from_weight + longest,
+                                       count - from - 1,
+                                       simulate ? HIERARCHY_ESTIMATE_HOP_LIMIT : SIZE_MAX,
+                                       simulate ? HIERARCHY_ESTIMATE_SETTLE_LIMIT : HIERARCHY_WITNESS_SETTLE_LIMIT);
+        for (size_t to = from + 1; to < count; to++) {
+            builder->is_target[builder->neighbors[to].target] = false;
+        }
+        if (!searched) {
+            return false;
+        }
+
+        for (size_t to = from + 1; to < count; to++) {
+            uint64_t weight = from_weight + builder->neighbors[to].weight;
+            if (builder->distances[builder->neighbors[to].target] <= weight) {
+                continue;
+            }
+
+            (*shortcut_count)++;
+            if (!simulate
+                && !add_shortcut(builder, builder->neighbors[from].target, builder->neighbors[to].target, weight,
+                                 node)) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+/*
+ * Prefers nodes that add few shortcuts for the edges they remove, and nodes
+ * with few contracted below them, which spreads the contraction evenly and
+ * keeps the searches of a query short.
+ */
+static bool node_priority(struct hierarchy_builder *builder, size_t node, uint64_t *priority) {
+    size_t shortcut_count;
+    size_t neighbor_count;
+
+    if (!contract_node(builder, node, true, &shortcut_count, &neighbor_count)) {
+        return false;
+    }
+    *priority = 100 * (uint64_t) builder->level[node]
+                + (neighbor_count > 0 ? 1000 * (uint64_t) shortcut_count / neighbor_count : 0);
+    return true;
+}
+
+static void builder_destroy(struct hierarchy_builder *builder) {
+    if (builder->adjacency != NULL) {
+        for (size_t node = 0; node < builder->node_count; node++) {
+            free(builder->adjacency[node].arcs);
+        }
+    }
+    free(builder->adjacency);
+    free(builder->contracted);
+    free(builder->level);
+    free(builder->priority);
+    free(builder->order.entries);
+    free(builder->distances);
+    free(builder->hops);
+    free(builder->touched);
+    free(builder->witness.entries);
+    free(builder->neighbors);
+    free(builder->is_target);
+    free(builder->target_limits);
+}
+
+static bool builder_init(struct hierarchy_builder *builder, const Graph *graph) {
+    size_t node_count = graph->node_count;
+
+    memset(builder, 0, sizeof(*builder));
+    builder->node_count = node_count;
+    builder->adjacency = calloc(node_count + 1, sizeof(struct hierarchy_arcs));
+    builder->contracted = calloc(node_count + 1, sizeof(bool));
+    builder->level = calloc(node_count + 1, sizeof(size_t));
+    builder->priority = malloc(node_count * sizeof(uint64_t) + 1);
+    builder->distances = malloc(node_count * sizeof(uint64_t) + 1);
+    builder->hops = malloc(node_count * sizeof(size_t) + 1);
+    builder->touched = malloc(node_count * sizeof(size_t) + 1);
+    builder->neighbors = malloc(node_count * sizeof(struct hierarchy_arc) + 1);
+    builder->is_target = calloc(node_count + 1, sizeof(bool));
+    builder->target_limits = malloc(node_count * sizeof(uint64_t) + 1);
+    if (builder->adjacency == NULL || builder->contracted == NULL || builder->level == NULL
+        || builder->priority == NULL || builder->distances == NULL || builder->hops == NULL
+        || builder->touched == NULL
+        || builder->neighbors == NULL || builder->is_target == NULL
+        || builder->target_limits == NULL) {
+        return false;
+    }
+
+    for (size_t node = 0; node < node_count; node++) {
+        builder->distances[node] = UINT64_MAX;
+        for (size_t k = graph->offsets[node]; k < graph->offsets[node + 1]; k++) {
+            struct hierarchy_arc arc = { graph->targets[k], graph->weights[k], HIERARCHY_NO_MIDDLE };
+            if (!add_arc(&builder->adjacency[node], arc)) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+/*
+ * Contracts the nodes in the order of their priority. Priorities are only
+ * updated lazily: a node taken from the queue is estimated again and put
+ * back if it no longer comes first. Estimating all the neighbors after each
+ * contraction instead costs far more than it improves the order.
+ */
+static bool order_nodes(struct hierarchy_builder *builder, size_t *rank) {
+    for (size_t node = 0; node < builder->node_count; node++) {
+        if (!node_priority(builder, node, &builder->priority[node])
+            || !heap_push(&builder->order, builder->priority[node], node)) {
+            return false;
+        }
+    }
+
+    size_t next_rank = 0;
+    while (builder->order.count > 0) {
+        struct hierarchy_heap_entry entry = heap_pop(&builder->order);
+        size_t node = entry.node;
+        if (builder->contracted[node] || entry.key != builder->priority[node]) {
+            continue;
+        }
+
+        uint64_t priority;
+        if (!node_priority(builder, node, &priority)) {
+            return false;
+        }
+        if (builder->order.count > 0 && priority > builder->order.entries[0].key) {
+            builder->priority[node] = priority;
+            if (!heap_push(&builder->order, priority, node)) {
+                return false;
+            }
+            continue;
+        }
+
+        size_t shortcut_count;
+        size_t neighbor_count;
+        if (!contract_node(builder, node, false, &shortcut_count, &neighbor_count)) {
+            return false;
+        }
+        builder->contracted[node] = true;
+        rank[node] = next_rank++;
+
+        for (size_t index = 0; index < neighbor_count; index++) {
+            size_t neighbor = builder->neighbors[index].target;
+            if (builder->level[neighbor] <= builder->level[node]) {
+                builder->level[neighbor] = builder->level[node] + 1;
+            }
+            remove_arc(&builder->adjacency[neighbor], node);
+        }
+    }
+
+    return true;
+}
+
+static int compare_arcs(const void *a, const void *b) {
+    size_t target_a = ((const struct hierarchy_arc *) a)->target;
+    size_t target_b = ((const struct hierarchy_arc *) b)->target;
+    return (target_a > target_b) - (target_a < target_b);
+}
+
+// Keeps the edges leading to higher ranks, sorted by node.
+static bool build_upward_graph(ContractionHierarchy *hierarchy, struct hierarchy_builder *builder) {
+    size_t node_count = hierarchy->node_count;
+
+    hierarchy->offsets = calloc(node_count + 1, sizeof(size_t));
+    if (hierarchy->offsets == NULL) {
+        return false;
+    }
+    for (size_t node = 0; node < node_count; node++) {
+        struct hierarchy_arcs *arcs = &builder->adjacency[node];
+        size_t upward = 0;
+
+        for (size_t index = 0; index < arcs->count; index++) {
+            if (hierarchy->rank[arcs->arcs[index].target] > hierarchy->rank[node]) {
+                arcs->arcs[upward++] = arcs->arcs[index];
+            }
+        }
+        arcs->count = upward;
+        if (upward > 0) {
+            qsort(arcs->arcs, upward, sizeof(struct hierarchy_arc), compare_arcs);
+        }
+        hierarchy->offsets[node + 1] = hierarchy->offsets[node] + upward;
+    }
+
+    size_t arc_count = hierarchy->offsets[node_count];
+    hierarchy->targets = malloc(arc_count * sizeof(size_t) + 1);
+    hierarchy->weights = malloc(arc_count * sizeof(uint64_t) + 1);
+    hierarchy->middles = malloc(arc_count * sizeof(size_t) + 1);
+    if (hierarchy->targets == NULL || hierarchy->weights == NULL || hierarchy->middles == NULL) {
+        return false;
+    }
+    for (size_t node = 0; node < node_count; node++) {
+        for (size_t index = 0; index < builder->adjacency[node].count; index++) {
+            const struct hierarchy_arc *arc = &builder->adjacency[node].arcs[index];
+            size_t k = hierarchy->offsets[node] + index;
+            hierarchy->targets[k] = arc->target;
+            hierarchy->weights[k] = arc->weight;
+            hierarchy->middles[k] = arc->middle;
+        }
+    }
+
+    return true;
+}
+
+bool hierarchy_build(ContractionHierarchy *hierarchy, const Graph *graph) {
+    assert(hierarchy != NULL && graph != NULL);
+
+    memset(hierarchy, 0, sizeof(*hierarchy));
+    hierarchy->node_count = graph->node_count;
+    hierarchy->rank = malloc(graph->node_count * sizeof(size_t) + 1);
+
+    struct hierarchy_builder builder;
+    bool built = hierarchy->rank != NULL && builder_init(&builder, graph) && order_nodes(&builder, hierarchy->rank)
+                 && build_upward_graph(hierarchy, &builder);
+    if (hierarchy->rank != NULL) {
+        builder_destroy(&builder);
+    }
+
+    if (!built) {
+        hierarchy_destroy(hierarchy);
+    }
+    return built;
+}
+
+// Returns the position of the upward edge from a to b, or the end of the edges of a if there is none.
+static size_t find_upward_edge(const ContractionHierarchy *hierarchy, size_t a, size_t b) {
+    size_t low = hierarchy->offsets[a];
+    size_t high = hierarchy->offsets[a + 1];
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (hierarchy->targets[middle] < b) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low < hierarchy->offsets[a + 1] && hierarchy->targets[low] == b ? low : hierarchy->offsets[a + 1];
+}
+
+// Returns the node a shortcut between a and b stands for.
+static size_t find_middle(const ContractionHierarchy *hierarchy, size_t a, size_t b) {
+    if (hierarchy->rank[a] > hierarchy->rank[b]) {
+        size_t swap = a;
+        a = b;
+        b = swap;
+    }
+
+    size_t position = find_upward_edge(hierarchy, a, b);
+    assert(position < hierarchy->offsets[a + 1]);
+
+    return hierarchy->middles[position];
+}
+
+bool hierarchy_valid(const ContractionHierarchy *hierarchy, size_t edge_count) {
+    assert(hierarchy != NULL);
+
+    size_t node_count = hierarchy->node_count;
+    if (hierarchy->offsets[0] != 0 || hierarchy->offsets[node_count] != edge_count) {
+        return false;
+    }
+    for (size_t node = 0; node < node_count; node++) {
+        if (hierarchy->rank[node] >= node_count || hierarchy->offsets[node] > hierarchy->offsets[node + 1]) {
+            return false;
+        }
+    }
+    for (size_t node = 0; node < node_count; node++) {
+        for (size_t k = hierarchy->offsets[node]; k < hierarchy->offsets[node + 1]; k++) {
+            size_t target = hierarchy->targets[k];
+            if (target >= node_count || hierarchy->rank[target] <= hierarchy->rank[node]
+                || (k > hierarchy->offsets[node] && hierarchy->targets[k - 1] >= target)) {
+                return false;
+            }
+        }
+    }
+
+    // The middle of a shortcut is contracted before both of its ends, so unpacking ends.
+    for (size_t node = 0; node < node_count; node++) {
+        for (size_t k = hierarchy->offsets[node]; k < hierarchy->offsets[node + 1]; k++) {
+            size_t middle = hierarchy->middles[k];
+            if (middle == HIERARCHY_NO_MIDDLE) {
+                continue;
+            }
+            if (middle >= node_count || hierarchy->rank[middle] >= hierarchy->rank[node]
+                || find_upward_edge(hierarchy, middle, node) == hierarchy->offsets[middle + 1]
+                || find_upward_edge(hierarchy, middle, hierarchy->targets[k]) == hierarchy->offsets[middle + 1]) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool hierarchy_unpack(const ContractionHierarchy *hierarchy, const size_t *nodes, size_t count, size_t **unpacked,
+                      size_t *unpacked_count) {
+    assert(hierarchy != NULL && nodes != NULL && count > 0 && unpacked != NULL && unpacked_count != NULL);
+
+    size_t capacity = count;
+    size_t *path = malloc(capacity * sizeof(size_t));
+    size_t stack_capacity = 16;
+    size_t stack_count = 0;
+    size_t *stack = malloc(stack_capacity * 2 * sizeof(size_t));
+    if (path == NULL || stack == NULL) {
+        free(path);
+        free(stack);
+        return false;
+    }
+
+    size_t path_count = 0;
+    path[path_count++] = nodes[0];
+    for (size_t index = 1; index < count; index++) {
+        stack[0] = nodes[index - 1];
+        stack[1] = nodes[index];
+        stack_count = 1;
+
+        // Edges are expanded left to right, so the nodes come out in the order of the path.
+        while (stack_count > 0) {
+            stack_count--;
+            size_t a = stack[2 * stack_count];
+            size_t b = stack[2 * stack_count + 1];
+            size_t middle = find_middle(hierarchy, a, b);
+
+            if (middle == HIERARCHY_NO_MIDDLE) {
+                if (path_count == capacity) {
+                    capacity *= 2;
+                    size_t *grown = realloc(path, capacity * sizeof(size_t));
+                    if (grown == NULL) {
+                        free(path);
+                        free(stack);
+                        return false;
+                    }
+                    path = grown;
+                }
+                path[path_count++] = b;
+                continue;
+            }
+
+            if (stack_count + 2 > stack_capacity) {
+                stack_capacity *= 2;
+                size_t *grown = realloc(stack, stack_capacity * 2 * sizeof(size_t));
+                if (grown == NULL) {
+                    free(path);
+                    free(stack);
+                    return false;
+                }
+                stack = grown;
+            }
+            stack[2 * stack_count] = middle;
+            stack[2 * stack_count + 1] = b;
+            stack[2 * stack_count + 2] = a;
+            stack[2 * stack_count + 3] = middle;
+            stack_count += 2;
+        }
+    }
+
+    free(stack);
+    *unpacked = path;
+    *unpacked_count = path_count;
+    return true;
+}
+
+void hierarchy_destroy(ContractionHierarchy *hierarchy) {
+    assert(hierarchy != NULL);
+
+    free(hierarchy->rank);
+    free(hierarchy->offsets);
+    free(hierarchy->targets);
+    free(hierarchy->weights);
+    free(hierarchy->middles);
+    memset(hierarchy, 0, sizeof(*hierarchy));
+}
@@ -0,0 +1,42 @@
+#ifndef HIERARCHY_H
+#define HIERARCHY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "graph.h"
+
+// Marks an edge of the hierarchy that is an edge of the original graph.
+#define HIERARCHY_NO_MIDDLE SIZE_MAX
+
+// Contraction hierarchy of an undirected graph. Nodes are contracted one by one in the order
+// of rank, and shortcuts keep the distances among the remaining nodes. The upward edges of
+// node u lead to nodes of higher rank: targets[offsets[u]] up to targets[offsets[u + 1] - 1]
+// sorted by node, a shortcut stands for the path through the node middles[k].
+typedef struct ContractionHierarchy {
+    size_t node_count;
+    size_t *rank;
+    size_t *offsets;
+    size_t *targets;
+    uint64_t *weights;
+    size_t *middles;
+} ContractionHierarchy;
+
+// Contracts the graph into the hierarchy. Returns false on allocation failure.
+bool hierarchy_build(ContractionHierarchy *hierarchy, const Graph *graph);
+
+// Replaces the shortcuts of a path of the hierarchy by the nodes they stand for. *unpacked
+// receives a new array of the nodes of the path in the graph. Returns false on allocation failure.
+bool hierarchy_unpack(const ContractionHierarchy *hierarchy, const size_t *nodes, size_t count, size_t **unpacked,
+                      size_t *unpacked_count);
+
+// Tells whether a hierarchy not built by hierarchy_build(), e.g. one read from a file, with arrays of
+// edge_count upward edges can be searched and unpacked safely: every edge leads to a node of higher
+// rank, the edges of a node are sorted, and a shortcut stands for two edges through a node of lower
+// rank. Whether the distances are right is not checked.
+bool hierarchy_valid(const ContractionHierarchy *hierarchy, size_t edge_count);
+
+// Frees the memory of the hierarchy.
+void hierarchy_destroy(ContractionHierarchy *hierarchy);
+
+#endif // HIERARCHY_H
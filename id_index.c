@@ -0,0 +1,77 @@
+#include "id_index.h"
+
+#include <assert.h>
+#include <stdlib.h>
+
+static uint64_t hash_id(uint64_t id) {
+    // Finalizer of splitmix64, spreads consecutive IDs over the whole table.
+    id ^= id >> 30;
+    id *= 0xbf58476d1ce4e5b9ULL;
+    id ^= id >> 27;
+    id *= 0x94d049bb133111ebULL;
+    id ^= id >> 31;
+    return id;
+}
+
+static size_t find_slot(const IdIndex *index, uint64_t id) {
+    size_t mask = index->capacity - 1;
+    size_t slot = hash_id(id) & mask;
+
+    while (index->rows[slot] != ID_INDEX_NOT_FOUND && index->keys[slot] != id) {
+        slot = (slot + 1) & mask;
+    }
+
+    return slot;
+}
+
+bool id_index_build(IdIndex *index, const uint64_t *ids, size_t count, bool *duplicate) {
+    assert(index != NULL && (ids != NULL || count == 0) && duplicate != NULL);
+
+    *duplicate = false;
+
+    // Keep the table at most half full.
+    index->capacity = 16;
+    while (index->capacity < count * 2) {
+        index->capacity *= 2;
+    }
+
+    index->keys = malloc(index->capacity * sizeof(uint64_t));
+    index->rows = malloc(index->capacity * sizeof(size_t));
+    if (index->keys == NULL || index->rows == NULL) {
+        id_index_destroy(index);
+        return false;
+    }
+
+    for (size_t slot = 0; slot < index->capacity; slot++) {
+        index->rows[slot] = ID_INDEX_NOT_FOUND;
+    }
+
+    for (size_t row = 0; row < count; row++) {
+        size_t slot = find_slot(index, ids[row]);
+        if (index->rows[slot] != ID_INDEX_NOT_FOUND) {
+            *duplicate = true;
+            id_index_destroy(index);
+            return false;
+        }
+        index->keys[slot] = ids[row];
+        index->rows[slot] = row;
+    }
+
+    return true;
+}
+
+size_t id_index_find(const IdIndex *index, uint64_t id) {
+    assert(index != NULL);
+
+    return index->rows[find_slot(index, id)];
+}
+
+void id_index_destroy(IdIndex *index) {
+    assert(index != NULL);
+
+    free(index->keys);
+    free(index->rows);
+    index->keys = NULL;
+    index->rows = NULL;
+    index->capacity = 0;
+}
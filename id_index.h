@@ -0,0 +1,27 @@
+#ifndef ID_INDEX_H
+#define ID_INDEX_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define ID_INDEX_NOT_FOUND SIZE_MAX
+
+// Open-addressing hash table mapping container IDs to their rows.
+typedef struct IdIndex {
+    uint64_t *keys;
+    size_t *rows;
+    size_t capacity;
+} IdIndex;
+
+// Indexes count IDs, ids[row] belongs to the given row. Returns false on allocation
+// failure or if an ID is not unique; *duplicate tells the two apart.
+bool id_index_build(IdIndex *index, const uint64_t *ids, size_t count, bool *duplicate);
+
+// Returns the row of the ID, or ID_INDEX_NOT_FOUND.
+size_t id_index_find(const IdIndex *index, uint64_t id);
+
+// Frees the memory of the index.
+void id_index_destroy(IdIndex *index);
+
+#endif // ID_INDEX_H
@@ -0,0 +1,135 @@
+#include "landmarks.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pqueue.h"
+
+// Stores the distances of all nodes from the source, LANDMARKS_UNREACHABLE for the others.
+static bool measure_distances(const Graph *graph, size_t source, uint64_t *distances) {
+    PriorityQueue queue;
+    if (!pqueue_init(&queue, PQUEUE_RADIX_HEAP, graph->node_count, NULL)) {
+        return false;
+    }
+    for (size_t node = 0; node < graph->node_count; node++) {
+        distances[node] = LANDMARKS_UNREACHABLE;
+    }
+    distances[source] = 0;
+
+    bool ok = pqueue_push(&queue, source, 0);
+    size_t node;
+    uint64_t distance;
+    while (ok && pqueue_pop(&queue, &node, &distance)) {
+        for (size_t k = graph->offsets[node]; k < graph->offsets[node + 1] && ok; k++) {
+            size_t neighbor = graph->targets[k];
+            uint64_t neighbor_distance = distance + graph->weights[k];
+
+            if (neighbor_distance < distances[neighbor]) {
+                distances[neighbor] = neighbor_distance;
+                ok = pqueue_push(&queue, neighbor, neighbor_distance);
+            }
+        }
+    }
+
+    pqueue_destroy(&queue);
+    return ok;
+}
+
+/*
+ * Farthest-point selection: every next landmark is the node farthest from
+ * the landmarks picked so far. Nodes no landmark reaches count as farthest,
+ * so every connected component gets a landmark while there are some left.
+ * Until all nodes are landmarks, the farthest node is never one already.
+ */
+bool landmarks_build(Landmarks *landmarks, const Graph *graph, size_t count) {
+    assert(landmarks != NULL && graph != NULL);
+
+    memset(landmarks, 0, sizeof(*landmarks));
+    landmarks->node_count = graph->node_count;
+    if (count > graph->node_count) {
+        count = graph->node_count;
+    }
+
+    uint64_t *nearest = malloc(graph->node_count * sizeof(uint64_t) + 1);
+    uint64_t *distances = malloc(graph->node_count * sizeof(uint64_t) + 1);
+    landmarks->nodes = malloc(count * sizeof(size_t) + 1);
+    landmarks->distances = malloc(count * graph->node_count * sizeof(uint64_t) + 1);
+    if (nearest == NULL || distances == NULL || landmarks->nodes == NULL || landmarks->distances == NULL) {
+        free(nearest);
+        free(distances);
+        landmarks_destroy(landmarks);
+        return false;
+    }
+    for (size_t node = 0; node < graph->node_count; node++) {
+        nearest[node] = LANDMARKS_UNREACHABLE;
+    }
+
+    // The first landmark is the node farthest from node 0, which lies at the edge of its component.
+    size_t next = 0;
+    bool ok = count == 0 || measure_distances(graph, 0, distances);
+    for (size_t node = 0; ok && count > 0 && node < graph->node_count; node++) {
+        if (distances[node] != LANDMARKS_UNREACHABLE && distances[node] > distances[next]) {
+            next = node;
+        }
+    }
+
+    for (size_t index = 0; ok && index < count; index++) {
+        ok = measure_distances(graph, next, distances);
+        if (!ok) {
+            break;
+        }
+        landmarks->nodes[index] = next;
+
+        for (size_t node = 0; node < graph->node_count; node++) {
+            landmarks->distances[node * count + index] = distances[node];
+            if (distances[node] < nearest[node]) {
+                nearest[node] = distances[node];
+            }
+        }
+        for (size_t node = 0; node < graph->node_count; node++) {
+            if (nearest[node] > nearest[next]) {
+                next = node;
+            }
+        }
+    }
+
+    landmarks->count = count;
+    free(nearest);
+    free(distances);
+    if (!ok) {
+        landmarks_destroy(landmarks);
+    }
+    return ok;
+}
+
+uint64_t landmarks_lower_bound(const Landmarks *landmarks, size_t node, size_t target) {
+    assert(landmarks != NULL && node < landmarks->node_count && target < landmarks->node_count);
+
+    uint64_t bound = 0;
+    for (size_t index = 0; index < landmarks->count; index++) {
+        uint64_t to_node = landmarks->distances[node * landmarks->count + index];
+        uint64_t to_target = landmarks->distances[target * landmarks->count + index];
+
+        if ((to_node == LANDMARKS_UNREACHABLE) != (to_target == LANDMARKS_UNREACHABLE)) {
+            return LANDMARKS_UNREACHABLE;
+        }
+        if (to_node == LANDMARKS_UNREACHABLE) {
+            continue;
+        }
+
+        uint64_t difference = to_node > to_target ? to_node - to_target : to_target - to_node;
+        if (difference > bound) {
+            bound = difference;
+        }
+    }
+
+    return bound;
+}
+
+void landmarks_destroy(Landmarks *landmarks) {
+    assert(landmarks != NULL);
+
+    free(landmarks->nodes);
+    free(landmarks->distances);
+    memset(landmarks, 0, sizeof(*landmarks));
+}
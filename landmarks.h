@@ -0,0 +1,32 @@
+#ifndef LANDMARKS_H
+#define LANDMARKS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "graph.h"
+
+// Marks a node that cannot be reached from a landmark, or a target that cannot be reached at all.
+#define LANDMARKS_UNREACHABLE UINT64_MAX
+
+// Landmark nodes with their exact distances to every node of the graph: the distance of
+// node u from landmark i is distances[u * count + i], so the bounds of a node share cache lines.
+typedef struct Landmarks {
+    size_t count;
+    size_t node_count;
+    size_t *nodes;
+    uint64_t *distances;
+} Landmarks;
+
+// Picks up to count landmarks far from each other and measures their distances to all nodes.
+// Returns false on allocation failure.
+bool landmarks_build(Landmarks *landmarks, const Graph *graph, size_t count);
+
+// Returns a lower bound of the distance between the node and the target given by the triangle
+// inequality, or LANDMARKS_UNREACHABLE if they are not connected.
+uint64_t landmarks_lower_bound(const Landmarks *landmarks, size_t node, size_t target);
+
+// Frees the memory of the landmarks.
+void landmarks_destroy(Landmarks *landmarks);
+
+#endif // LANDMARKS_H
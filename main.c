@@ -1,18 +1,112 @@
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include "batch.h"
+#include "container_stream.h"
 #include "data_source.h"
+#include "parallel.h"
 #include "parse_args.h"
+#include "server.h"
 
 int main(int argc, char *argv[])
 {
     Filters filters = parse_args(argc, argv);
-    init_data_source(filters.containers_path, filters.paths_path);
+    if (filters.unpublish_flag) {
+        if (!data_source_remove_shared_files(filters.containers_path, filters.paths_path)) {
+            fprintf(stderr, "No data of the input files is published to shared memory\n");
+            return EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
+    }
+    if (filters.stream_flag) {
+        if (!stream_containers(filters.containers_path, filters.paths_path, filters, stdout)) {
+            fprintf(stderr, "Failed to read valid input files\n");
+            return EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
+    }
+
+    // A mapped snapshot is read whole to verify its checksum, which costs far less than parsing the
+    // input files, so a damaged one is never answered from.
+    DataSourceOptions options = { filters.snapshot_path, NULL, CONTAINER_COLUMNS_ALL, false, true };
+    // A single query only needs its own columns, unless the tables are saved for later ones.
+    if (!filters.preload_flag && filters.socket_path == NULL && filters.batch_path == NULL
+        && filters.snapshot_path == NULL) {
+        if (filters.route_flag || filters.special_flag) {
+            options.columns = DATA_SOURCE_STATION_COLUMNS;
+        } else {
+            // A plain listing prints only the containers passing its filters, the others need no strings.
+            options.columns = DATA_SOURCE_LISTING_COLUMNS;
+            options.filters = &filters;
+        }
+    }
+    DataSource *source = data_source_open_with(filters.containers_path, filters.paths_path, &options);
+    if (source == NULL) {
+        fprintf(stderr, "Failed to load input files\n");
+        return EXIT_FAILURE;
+    }
+    // The next run maps the tables instead of loading the input files again.
+    if (filters.snapshot_path != NULL && !data_source_snapshot_mapped(source)
+        && !data_source_write_snapshot(source, filters.snapshot_path)) {
+        fprintf(stderr, "Failed to write the snapshot file, continuing without it\n");
+    }
 
-    if (filters.special_flag) {
-        print_stations();
-    } else {
-        print_containers(filters);
+    if (filters.preload_flag) {
+        if (!data_source_publish_shared(source)) {
+            fprintf(stderr, "Failed to publish the data to shared memory\n");
+            data_source_close(source);
+            return EXIT_FAILURE;
+        }
+    } else if (filters.socket_path != NULL) {
+        if (!run_server(source, filters.socket_path, parallel_worker_count())) {
+            fprintf(stderr, "Failed to start the server\n");
+            data_source_close(source);
+            return EXIT_FAILURE;
+        }
+    } else if (filters.batch_path != NULL) {
+        FILE *commands = strcmp(filters.batch_path, "-") == 0 ? stdin : fopen(filters.batch_path, "r");
+        if (commands == NULL) {
+            fprintf(stderr, "Failed to open the commands file\n");
+            data_source_close(source);
+            return EXIT_FAILURE;
+        }
+        bool ok = run_batch(source, commands, stdout, NULL);
+        if (commands != stdin) {
+            fclose(commands);
+        }
+        if (!ok) {
+            data_source_close(source);
+            return EXIT_FAILURE;
+        }
+    } else if (filters.route_flag) {
+        size_t station_count = data_source_station_table(source)->count;
+        if (filters.route_from > station_count || filters.route_to > station_count) {
+            fprintf(stderr, "Station ID out of range, there are %zu stations\n", station_count);
+            data_source_close(source);
+            return EXIT_FAILURE;
+        }
+        // Contracting the stations costs far more than the one route searched with the hierarchy.
+        if (filters.route_options.algorithm == ROUTE_CONTRACTION_HIERARCHY && filters.snapshot_path == NULL
+            && !data_source_snapshot_mapped(source)) {
+            fprintf(stderr, "Contracting the stations for a single route, use -S or -P to keep the hierarchy\n");
+        }
+        if (!data_source_print_route(source, filters.route_from, filters.route_to, &filters.route_options, stdout)) {
+            fprintf(stderr, "Failed to find the route\n");
+            data_source_close(source);
+            return EXIT_FAILURE;
+        }
+    } else if (filters.special_flag) {
+        if (!data_source_print_stations(source, stdout)) {
+            fprintf(stderr, "Failed to list the stations\n");
+            data_source_close(source);
+            return EXIT_FAILURE;
+        }
+    } else if (!data_source_print_containers(source, filters, stdout)) {
+        fprintf(stderr, "Failed to list the containers\n");
+        data_source_close(source);
+        return EXIT_FAILURE;
     }
 
-    destroy_data_source();
+    data_source_close(source);
     return EXIT_SUCCESS;
 }
@@ -0,0 +1,83 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "parallel.h"
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+struct parallel_worker {
+    pthread_t thread;
+    bool started;
+    ParallelTask task;
+    void *context;
+    size_t first;
+    size_t stride;
+    size_t task_count;
+};
+
+static void *run_worker(void *arg) {
+    struct parallel_worker *worker = arg;
+
+    for (size_t index = worker->first; index < worker->task_count; index += worker->stride) {
+        worker->task(worker->context, index);
+    }
+
+    return NULL;
+}
+
+size_t parallel_worker_count(void) {
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 1 ? (size_t) count : 1;
+}
+
+void parallel_for(size_t task_count, size_t worker_count, ParallelTask task, void *context) {
+    assert(task != NULL);
+
+    if (worker_count > task_count) {
+        worker_count = task_count;
+    }
+
+    struct parallel_worker *workers = NULL;
+    if (worker_count > 1) {
+        workers = calloc(worker_count, sizeof(struct parallel_worker));
+    }
+
+    if (workers == NULL) {
+        for (size_t index = 0; index < task_count; index++) {
+            task(context, index);
+        }
+        return;
+    }
+
+    for (size_t index = 0; index < worker_count; index++) {
+        workers[index].task = task;
+        workers[index].context = context;
+        workers[index].first = index;
+        workers[index].stride = worker_count;
+        workers[index].task_count = task_count;
+    }
+
+    // The calling thread takes the first share of the tasks and the share of
+    // any thread that could not be started.
+    for (size_t index = 1; index < worker_count; index++) {
+        workers[index].started = pthread_create(&workers[index].thread, NULL, run_worker, &workers[index]) == 0;
+    }
+
+    run_worker(&workers[0]);
+    for (size_t index = 1; index < worker_count; index++) {
+        if (!workers[index].started) {
+            run_worker(&workers[index]);
+        }
+    }
+
+    for (size_t index = 1; index < worker_count; index++) {
+        if (workers[index].started) {
+            pthread_join(workers[index].thread, NULL);
+        }
+    }
+
+    free(workers);
+}
@@ -0,0 +1,15 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <stddef.h>
+
+typedef void (*ParallelTask)(void *context, size_t index);
+
+// Returns the number of CPUs available to run tasks on, at least 1.
+size_t parallel_worker_count(void);
+
+// Calls task(context, index) for every index below task_count, spreading the calls
+// over up to worker_count threads. Returns after all the calls have finished.
+void parallel_for(size_t task_count, size_t worker_count, ParallelTask task, void *context);
+
+#endif // PARALLEL_H
@@ -1,47 +1,160 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include <unistd.h>
+#include <ctype.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include "container_stream.h"
 #include "parse_args.h"
 
+// Parses "X,Y" of two station IDs, both starting from 1.
+static bool parse_route(const char *text, Filters *filters) {
+    char *end;
+
+    if (!isdigit((unsigned char) text[0])) {
+        return false;
+    }
+    unsigned long long from = strtoull(text, &end, 10);
+    if (*end != ',' || !isdigit((unsigned char) end[1])) {
+        return false;
+    }
+    unsigned long long to = strtoull(end + 1, &end, 10);
+    if (*end != '\0' || from == 0 || to == 0 || from > SIZE_MAX || to > SIZE_MAX) {
+        return false;
+    }
+
+    filters->route_from = (size_t) from;
+    filters->route_to = (size_t) to;
+    return true;
+}
+
+Filters default_filters(void) {
+    Filters filters = {0, 0, 0, 0, NULL, NULL, 0, 0, 0, 0, {ROUTE_DIJKSTRA, PQUEUE_RADIX_HEAP, NULL, NULL, NULL}, NULL, NULL, NULL, 0, 0, 0};
+    return filters;
+}
+
+bool parse_option(int option, const char *value, Filters *filters) {
+    switch (option) {
+        case 't':
+            for (size_t i = 0; value[i] != '\0'; ++i) {
+                WasteType type;
+                if (!waste_type_from_letter(value[i], &type)) {
+                    fprintf(stderr, "Invalid waste type '%c'. Use letters of A, P, B, G, C, T.\n", value[i]);
+                    return false;
+                }
+                filters->waste_types |= WASTE_TYPE_MASK(type);
+            }
+            return true;
+        case 'c':
+            sscanf(value, "%d-%d", &filters->capacity_min, &filters->capacity_max);
+            return true;
+        case 'p':
+            if ((value[0] == 'Y' || value[0] == 'N') && value[1] == '\0') {
+                filters->public_filter = value[0];
+                return true;
+            }
+            fprintf(stderr, "Invalid value for public_filter. Use 'Y' or 'N'.\n");
+            return false;
+        case 'g':
+            if (filters->route_flag || !parse_route(value, filters)) {
+                fprintf(stderr, "Invalid value for -g. Use two station IDs as X,Y.\n");
+                return false;
+            }
+            filters->route_flag = 1;
+            return true;
+        case 'q':
+            if (!pqueue_kind_parse(value, &filters->route_options.queue)) {
+                fprintf(stderr, "Invalid priority queue '%s'. Use binary, pairing or radix.\n", value);
+                return false;
+            }
+            return true;
+        case 'a':
+            if (!route_algorithm_parse(value, &filters->route_options.algorithm)) {
+                fprintf(stderr, "Invalid route algorithm '%s'. Use dijkstra, bidirectional, ch or alt.\n", value);
+                return false;
+            }
+            return true;
+        default:
+            return false;
+    }
+}
+
 Filters parse_args(int argc, char *argv[]) {
-    Filters filters = {{"", "", "", "", "", "", "", ""}, 0, 0, 0, NULL, NULL};
+    Filters filters = default_filters();
+    bool route_option_given = false;
+    bool filter_given = false;
     int opt;
 
-    while ((opt = getopt(argc, argv, "t:c:p:s")) != -1) {
+    while ((opt = getopt(argc, argv, "t:c:p:sg:q:a:b:d:S:PRm")) != -1) {
+        filter_given |= opt == 't' || opt == 'c' || opt == 'p';
+        route_option_given |= opt == 'q' || opt == 'a';
         switch (opt) {
             case 't':
-                for (size_t i = 0; optarg[i] != '\0' && filters.waste_type_count < 8; ++i) {
-                    filters.waste_types[filters.waste_type_count][0] = optarg[i];
-                    filters.waste_types[filters.waste_type_count][1] = '\0';
-                    filters.waste_type_count++;
-                }
-                break;
             case 'c':
-                sscanf(optarg, "%d-%d", &filters.capacity_min, &filters.capacity_max);
-                break;
             case 'p':
-                // Modify support for public filter
-                if (optarg[0] == 'N') {
-                    filters.public_filter = 1;
-                } else if (optarg[0] == 'Y') {
-                    filters.public_filter = -1;
-                } else {
-                    fprintf(stderr, "Invalid value for public_filter. Use 'Y' or 'N'.\n");
+            case 'g':
+            case 'q':
+            case 'a':
+                if (!parse_option(opt, optarg, &filters)) {
                     exit(EXIT_FAILURE);
                 }
                 break;
             case 's':
                 filters.special_flag = 1;
                 break;
+            case 'b':
+                filters.batch_path = optarg;
+                break;
+            case 'd':
+                filters.socket_path = optarg;
+                break;
+            case 'S':
+                filters.snapshot_path = optarg;
+                break;
+            case 'P':
+                filters.preload_flag = 1;
+                break;
+            case 'R':
+                filters.unpublish_flag = 1;
+                break;
+            case 'm':
+                filters.stream_flag = 1;
+                break;
             default:
                 fprintf(stderr,
-                        "Usage: %s [-t waste_type] [-c min_capacity-max_capacity] [-p public_filter] containers_file paths_file\n",
+                        "Usage: %s [-t waste_type] [-c min_capacity-max_capacity] [-p public_filter] [-m] [-s]"
+                        " [-g from,to [-a dijkstra|bidirectional|ch|alt] [-q binary|pairing|radix]]"
+                        " [-b commands_file | -d socket_path | -P | -R] [-S snapshot_file] containers_file paths_file\n",
                         argv[0]);
                 exit(EXIT_FAILURE);
         }
     }
 
+    if ((filters.route_flag && (filters.special_flag || filter_given)) || (route_option_given && !filters.route_flag)) {
+        fprintf(stderr, "Option -g cannot be combined with -t, -c, -p or -s, and -a and -q need -g\n");
+        exit(EXIT_FAILURE);
+    }
+    if ((filters.batch_path != NULL || filters.socket_path != NULL)
+        && (filters.route_flag || filters.special_flag || filter_given
+            || (filters.batch_path != NULL && filters.socket_path != NULL))) {
+        fprintf(stderr, "Options -b and -d cannot be combined with other options, pass them in the commands\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (filters.preload_flag && (filters.route_flag || filters.special_flag || filter_given
+                                 || filters.batch_path != NULL || filters.socket_path != NULL)) {
+        fprintf(stderr, "Option -P only loads the input files, it cannot be combined with other options but -S\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (filters.unpublish_flag && (filters.route_flag || filters.special_flag || filter_given
+                                   || filters.batch_path != NULL || filters.socket_path != NULL
+                                   || filters.snapshot_path != NULL || filters.preload_flag)) {
+        fprintf(stderr, "Option -R only removes the data published by -P, it cannot be combined with other options\n");
+        exit(EXIT_FAILURE);
+    }
+
     if (optind + 1 >= argc) {
         fprintf(stderr, "Expected containers_file and paths_file arguments\n");
         exit(EXIT_FAILURE);
@@ -50,5 +163,22 @@ Filters parse_args(int argc, char *argv[]) {
     filters.containers_path = argv[optind];
     filters.paths_path = argv[optind + 1];
 
+    // Only the streaming listing reads a file once, so only it can read the standard input.
+    bool from_stdin = strcmp(filters.containers_path, CONTAINER_STREAM_STDIN) == 0;
+    if (strcmp(filters.paths_path, CONTAINER_STREAM_STDIN) == 0) {
+        if (from_stdin) {
+            fprintf(stderr, "Only one of the input files can be read from the standard input\n");
+            exit(EXIT_FAILURE);
+        }
+        from_stdin = true;
+    }
+    filters.stream_flag |= from_stdin;
+    if (filters.stream_flag && (filters.route_flag || filters.special_flag || filters.batch_path != NULL
+                                || filters.socket_path != NULL || filters.snapshot_path != NULL
+                                || filters.preload_flag || filters.unpublish_flag)) {
+        fprintf(stderr, "Option -m and input files read from '-' only list containers with -t, -c and -p\n");
+        exit(EXIT_FAILURE);
+    }
+
     return filters;
 }
@@ -4,4 +4,11 @@
 
 Filters parse_args(int argc, char *argv[]);
 
+// Returns the filters of a listing of all containers with the default route options.
+Filters default_filters(void);
+
+// Applies the option -t, -c, -p, -g, -q or -a with its value to the filters. Prints the reason
+// to stderr and returns false if the value is invalid.
+bool parse_option(int option, const char *value, Filters *filters);
+
 #endif /* PARSE_ARGS_H */
@@ -0,0 +1,64 @@
+#include "path.h"
+#include <stdlib.h>
+#include <string.h>
+#include "container.h"
+
+// Column order of the paths file
+enum path_column {
+    COLUMN_A,
+    COLUMN_B,
+    COLUMN_DISTANCE,
+};
+
+bool path_table_init(PathTable *table, size_t count) {
+    table->count = count;
+    table->a_id = malloc(count * sizeof(uint64_t) + 1);
+    table->b_id = malloc(count * sizeof(uint64_t) + 1);
+    table->distance = malloc(count * sizeof(uint32_t) + 1);
+    table->a_row = malloc(count * sizeof(size_t) + 1);
+    table->b_row = malloc(count * sizeof(size_t) + 1);
+
+    if (table->a_id == NULL || table->b_id == NULL || table->distance == NULL
+        || table->a_row == NULL || table->b_row == NULL) {
+        path_table_destroy(table);
+        return false;
+    }
+
+    return true;
+}
+
+bool path_table_set(PathTable *table, size_t index, const char *const *fields) {
+    uint64_t distance;
+
+    if (!parse_unsigned(fields[COLUMN_A], UINT64_MAX, &table->a_id[index])
+        || !parse_unsigned(fields[COLUMN_B], UINT64_MAX, &table->b_id[index])
+        || !parse_unsigned(fields[COLUMN_DISTANCE], INT32_MAX, &distance)
+        || distance == 0) {
+        return false;
+    }
+    table->distance[index] = (uint32_t) distance;
+
+    return true;
+}
+
+bool path_table_resolve(PathTable *table, const IdIndex *containers) {
+    for (size_t index = 0; index < table->count; index++) {
+        table->a_row[index] = id_index_find(containers, table->a_id[index]);
+        table->b_row[index] = id_index_find(containers, table->b_id[index]);
+
+        if (table->a_row[index] == ID_INDEX_NOT_FOUND || table->b_row[index] == ID_INDEX_NOT_FOUND) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void path_table_destroy(PathTable *table) {
+    free(table->a_id);
+    free(table->b_id);
+    free(table->distance);
+    free(table->a_row);
+    free(table->b_row);
+    memset(table, 0, sizeof(*table));
+}
@@ -0,0 +1,35 @@
+#ifndef PATH_H
+#define PATH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "id_index.h"
+
+// Paths between containers stored column by column, converted from text once when loaded.
+typedef struct PathTable {
+    size_t count;
+    uint64_t *a_id;
+    uint64_t *b_id;
+    uint32_t *distance;
+
+    // Rows of the endpoints in the containers file, see path_table_resolve().
+    size_t *a_row;
+    size_t *b_row;
+} PathTable;
+
+// Allocates the columns for count paths. Returns false on allocation failure.
+bool path_table_init(PathTable *table, size_t count);
+
+// Converts and validates one row of the paths file and stores it at index.
+// Returns false if any of the fields is invalid.
+bool path_table_set(PathTable *table, size_t index, const char *const *fields);
+
+// Looks up the rows of both endpoints of every path. Returns false on allocation
+// failure or if an endpoint is not in the index.
+bool path_table_resolve(PathTable *table, const IdIndex *containers);
+
+// Frees the columns of the table.
+void path_table_destroy(PathTable *table);
+
+#endif // PATH_H
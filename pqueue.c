@@ -0,0 +1,541 @@
+#include "pqueue.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PQUEUE_NONE SIZE_MAX
+
+struct pqueue_ops {
+    void *(*create)(size_t node_count, Arena *arena);
+    bool (*push)(void *state, size_t node, uint64_t key);
+    bool (*pop)(void *state, size_t *node, uint64_t *key);
+    void (*destroy)(void *state);
+};
+
+// Takes the memory of a queue from the arena, or from the heap without one.
+static void *pqueue_alloc(Arena *arena, size_t size) {
+    return arena != NULL ? arena_alloc(arena, size) : malloc(size);
+}
+
+static void *pqueue_alloc_zeroed(Arena *arena, size_t size) {
+    void *memory = pqueue_alloc(arena, size);
+    if (memory != NULL) {
+        memset(memory, 0, size);
+    }
+    return memory;
+}
+
+// Memory taken from an arena stays there until the arena is reset.
+static void pqueue_free(Arena *arena, void *memory) {
+    if (arena == NULL) {
+        free(memory);
+    }
+}
+
+// Current key of every node, UINT64_MAX until it is pushed.
+static uint64_t *create_keys(size_t node_count, Arena *arena) {
+    uint64_t *keys = pqueue_alloc(arena, node_count * sizeof(uint64_t) + 1);
+    if (keys != NULL) {
+        for (size_t node = 0; node < node_count; node++) {
+            keys[node] = UINT64_MAX;
+        }
+    }
+    return keys;
+}
+
+/*
+ * Binary heap of nodes with the position of every node in the heap,
+ * so that lowering a key only sifts the node up.
+ */
+struct binary_heap {
+    size_t *heap;
+    size_t *position;
+    uint64_t *keys;
+    size_t size;
+    Arena *arena;
+};
+
+static void binary_heap_destroy(void *state) {
+    struct binary_heap *heap = state;
+
+    if (heap != NULL) {
+        pqueue_free(heap->arena, heap->heap);
+        pqueue_free(heap->arena, heap->position);
+        pqueue_free(heap->arena, heap->keys);
+        pqueue_free(heap->arena, heap);
+    }
+}
+
+static void *binary_heap_create(size_t node_count, Arena *arena) {
+    struct binary_heap *heap = pqueue_alloc_zeroed(arena, sizeof(struct binary_heap));
+    if (heap == NULL) {
+        return NULL;
+    }
+
+    heap->arena = arena;
+    heap->heap = pqueue_alloc(arena, node_count * sizeof(size_t) + 1);
+    heap->position = pqueue_alloc(arena, node_count * sizeof(size_t) + 1);
+    heap->keys = create_keys(node_count, arena);
+    if (heap->heap == NULL || heap->position == NULL || heap->keys == NULL) {
+        binary_heap_destroy(heap);
+        return NULL;
+    }
+    for (size_t node = 0; node < node_count; node++) {
+        heap->position[node] = PQUEUE_NONE;
+    }
+
+    return heap;
+}
+
+static void binary_heap_place(struct binary_heap *heap, size_t index, size_t node) {
+    heap->heap[index] = node;
+    heap->position[node] = index;
+}
+
+static void binary_heap_sift_up(struct binary_heap *heap, size_t index, size_t node) {
+    while (index > 0) {
+        size_t parent = (index - 1) / 2;
+        if (heap->keys[heap->heap[parent]] <= heap->keys[node]) {
+            break;
+        }
+        binary_heap_place(heap, index, heap->heap[parent]);
+        index = parent;
+    }
+    binary_heap_place(heap, index, node);
+}
+
+static void binary_heap_sift_down(struct binary_heap *heap, size_t index, size_t node) {
+    size_t child;
+
+    while ((child = 2 * index + 1) < heap->size) {
+        if (child + 1 < heap->size && heap->keys[heap->heap[child + 1]] < heap->keys[heap->heap[child]]) {
+            child++;
+        }
+        if (heap->keys[heap->heap[child]] >= heap->keys[node]) {
+            break;
+        }
+        binary_heap_place(heap, index, heap->heap[child]);
+        index = child;
+    }
+    binary_heap_place(heap, index, node);
+}
+
+static bool binary_heap_push(void *state, size_t node, uint64_t key) {
+    struct binary_heap *heap = state;
+
+    if (key >= heap->keys[node]) {
+        return true;
+    }
+    heap->keys[node] = key;
+    if (heap->position[node] == PQUEUE_NONE) {
+        heap->position[node] = heap->size++;
+    }
+    binary_heap_sift_up(heap, heap->position[node], node);
+
+    return true;
+}
+
+static bool binary_heap_pop(void *state, size_t *node, uint64_t *key) {
+    struct binary_heap *heap = state;
+
+    if (heap->size == 0) {
+        return false;
+    }
+    *node = heap->heap[0];
+    *key = heap->keys[*node];
+    heap->position[*node] = PQUEUE_NONE;
+    if (--heap->size > 0) {
+        binary_heap_sift_down(heap, 0, heap->heap[heap->size]);
+    }
+
+    return true;
+}
+
+/*
+ * Pairing heap stored in arrays indexed by node. The first child of a node
+ * links back to its parent, the other children to their left siblings.
+ */
+struct pairing_node {
+    size_t child;
+    size_t sibling;
+    size_t prev;
+};
+
+struct pairing_heap {
+    struct pairing_node *nodes;
+    uint64_t *keys;
+    bool *queued;
+    size_t *roots;
+    size_t root;
+    Arena *arena;
+};
+
+static void pairing_heap_destroy(void *state) {
+    struct pairing_heap *heap = state;
+
+    if (heap != NULL) {
+        pqueue_free(heap->arena, heap->nodes);
+        pqueue_free(heap->arena, heap->keys);
+        pqueue_free(heap->arena, heap->queued);
+        pqueue_free(heap->arena, heap->roots);
+        pqueue_free(heap->arena, heap);
+    }
+}
+
+static void *pairing_heap_create(size_t node_count, Arena *arena) {
+    struct pairing_heap *heap = pqueue_alloc_zeroed(arena, sizeof(struct pairing_heap));
+    if (heap == NULL) {
+        return NULL;
+    }
+
+    heap->arena = arena;
+    heap->nodes = pqueue_alloc(arena, node_count * sizeof(struct pairing_node) + 1);
+    heap->keys = create_keys(node_count, arena);
+    heap->queued = pqueue_alloc_zeroed(arena, (node_count + 1) * sizeof(bool));
+    heap->roots = pqueue_alloc(arena, node_count * sizeof(size_t) + 1);
+    if (heap->nodes == NULL || heap->keys == NULL || heap->queued == NULL || heap->roots == NULL) {
+        pairing_heap_destroy(heap);
+        return NULL;
+    }
+    heap->root = PQUEUE_NONE;
+
+    return heap;
+}
+
+// Links two roots, the one with the greater key becomes the first child of the other.
+static size_t pairing_heap_meld(struct pairing_heap *heap, size_t a, size_t b) {
+    if (heap->keys[b] < heap->keys[a]) {
+        size_t swap = a;
+        a = b;
+        b = swap;
+    }
+
+    struct pairing_node *parent = &heap->nodes[a];
+    heap->nodes[b].sibling = parent->child;
+    heap->nodes[b].prev = a;
+    if (parent->child != PQUEUE_NONE) {
+        heap->nodes[parent->child].prev = b;
+    }
+    parent->child = b;
+
+    return a;
+}
+
+static void pairing_heap_cut(struct pairing_heap *heap, size_t node) {
+    struct pairing_node *cut = &heap->nodes[node];
+
+    if (heap->nodes[cut->prev].child == node) {
+        heap->nodes[cut->prev].child = cut->sibling;
+    } else {
+        heap->nodes[cut->prev].sibling = cut->sibling;
+    }
+    if (cut->sibling != PQUEUE_NONE) {
+        heap->nodes[cut->sibling].prev = cut->prev;
+    }
+    cut->sibling = PQUEUE_NONE;
+    cut->prev = PQUEUE_NONE;
+}
+
+static bool pairing_heap_push(void *state, size_t node, uint64_t key) {
+    struct pairing_heap *heap = state;
+
+    if (key >= heap->keys[node]) {
+        return true;
+    }
+    heap->keys[node] = key;
+
+    if (!heap->queued[node]) {
+        heap->queued[node] = true;
+        heap->nodes[node] = (struct pairing_node) { PQUEUE_NONE, PQUEUE_NONE, PQUEUE_NONE };
+    } else if (node != heap->root) {
+        pairing_heap_cut(heap, node);
+    } else {
+        return true;
+    }
+    heap->root = heap->root == PQUEUE_NONE ? node : pairing_heap_meld(heap, heap->root, node);
+
+    return true;
+}
+
+static bool pairing_heap_pop(void *state, size_t *node, uint64_t *key) {
+    struct pairing_heap *heap = state;
+
+    if (heap->root == PQUEUE_NONE) {
+        return false;
+    }
+    *node = heap->root;
+    *key = heap->keys[*node];
+    heap->queued[*node] = false;
+
+    size_t count = 0;
+    for (size_t child = heap->nodes[*node].child; child != PQUEUE_NONE;) {
+        size_t next = heap->nodes[child].sibling;
+        heap->nodes[child].sibling = PQUEUE_NONE;
+        heap->nodes[child].prev = PQUEUE_NONE;
+        heap->roots[count++] = child;
+        child = next;
+    }
+
+    // Two-pass pairing: meld the children in pairs from the left, then the pairs from the right.
+    size_t pairs = 0;
+    for (size_t index = 0; index < count; index += 2) {
+        heap->roots[pairs++] = index + 1 < count
+            ? pairing_heap_meld(heap, heap->roots[index], heap->roots[index + 1])
+            : heap->roots[index];
+    }
+    heap->root = pairs > 0 ? heap->roots[pairs - 1] : PQUEUE_NONE;
+    while (pairs > 1) {
+        pairs--;
+        heap->root = pairing_heap_meld(heap, heap->roots[pairs - 1], heap->root);
+    }
+
+    return true;
+}
+
+/*
+ * Radix heap: entries are kept in buckets by the highest bit in which their
+ * key differs from the last popped key. Lowering a key adds another entry,
+ * the outdated one is dropped when it is reached. Entries live in one pool
+ * and are linked into buckets, so moving them between buckets never allocates.
+ */
+#define RADIX_BUCKET_COUNT 65
+
+struct radix_entry {
+    uint64_t key;
+    size_t node;
+    size_t next;
+};
+
+struct radix_heap {
+    struct radix_entry *entries;
+    size_t entry_count;
+    size_t entry_capacity;
+    size_t free_entries;
+    size_t buckets[RADIX_BUCKET_COUNT];
+    uint64_t *keys;
+    bool *queued;
+    uint64_t last;
+    Arena *arena;
+};
+
+static void radix_heap_destroy(void *state) {
+    struct radix_heap *heap = state;
+
+    if (heap != NULL) {
+        pqueue_free(heap->arena, heap->entries);
+        pqueue_free(heap->arena, heap->keys);
+        pqueue_free(heap->arena, heap->queued);
+        pqueue_free(heap->arena, heap);
+    }
+}
+
+static void *radix_heap_create(size_t node_count, Arena *arena) {
+    struct radix_heap *heap = pqueue_alloc_zeroed(arena, sizeof(struct radix_heap));
+    if (heap == NULL) {
+        return NULL;
+    }
+
+    heap->arena = arena;
+    heap->keys = create_keys(node_count, arena);
+    heap->queued = pqueue_alloc_zeroed(arena, (node_count + 1) * sizeof(bool));
+    if (heap->keys == NULL || heap->queued == NULL) {
+        radix_heap_destroy(heap);
+        return NULL;
+    }
+    heap->free_entries = PQUEUE_NONE;
+    for (size_t bucket = 0; bucket < RADIX_BUCKET_COUNT; bucket++) {
+        heap->buckets[bucket] = PQUEUE_NONE;
+    }
+
+    return heap;
+}
+
+static size_t radix_bucket_of(const struct radix_heap *heap, uint64_t key) {
+    uint64_t difference = key ^ heap->last;
+    size_t bucket = 0;
+
+    while (difference != 0) {
+        difference >>= 1;
+        bucket++;
+    }
+
+    return bucket;
+}
+
+static void radix_heap_link(struct radix_heap *heap, size_t entry) {
+    size_t bucket = radix_bucket_of(heap, heap->entries[entry].key);
+
+    heap->entries[entry].next = heap->buckets[bucket];
+    heap->buckets[bucket] = entry;
+}
+
+static void radix_heap_release(struct radix_heap *heap, size_t entry) {
+    heap->entries[entry].next = heap->free_entries;
+    heap->free_entries = entry;
+}
+
+static bool radix_heap_is_current(const struct radix_heap *heap, size_t entry) {
+    size_t node = heap->entries[entry].node;
+    return heap->queued[node] && heap->keys[node] == heap->entries[entry].key;
+}
+
+static bool radix_heap_push(void *state, size_t node, uint64_t key) {
+    struct radix_heap *heap = state;
+
+    if (key >= heap->keys[node]) {
+        return true;
+    }
+    assert(key >= heap->last);
+
+    size_t entry = heap->free_entries;
+    if (entry != PQUEUE_NONE) {
+        heap->free_entries = heap->entries[entry].next;
+    } else {
+        if (heap->entry_count == heap->entry_capacity) {
+            size_t capacity = heap->entry_capacity > 0 ? heap->entry_capacity * 2 : 64;
+            struct radix_entry *entries;
+            if (heap->arena != NULL) {
+                // The old pool stays in the arena, the pools together take at most twice the last one.
+                entries = arena_alloc(heap->arena, capacity * sizeof(struct radix_entry));
+                if (entries != NULL && heap->entry_count > 0) {
+                    memcpy(entries, heap->entries, heap->entry_count * sizeof(struct radix_entry));
+                }
+            } else {
+                entries = realloc(heap->entries, capacity * sizeof(struct radix_entry));
+            }
+            if (entries == NULL) {
+                return false;
+            }
+            heap->entries = entries;
+            heap->entry_capacity = capacity;
+        }
+        entry = heap->entry_count++;
+    }
+
+    heap->keys[node] = key;
+    heap->queued[node] = true;
+    heap->entries[entry].key = key;
+    heap->entries[entry].node = node;
+    radix_heap_link(heap, entry);
+
+    return true;
+}
+
+static bool radix_heap_pop(void *state, size_t *node, uint64_t *key) {
+    struct radix_heap *heap = state;
+
+    for (;;) {
+        while (heap->buckets[0] != PQUEUE_NONE) {
+            size_t entry = heap->buckets[0];
+            heap->buckets[0] = heap->entries[entry].next;
+            radix_heap_release(heap, entry);
+
+            if (radix_heap_is_current(heap, entry)) {
+                *node = heap->entries[entry].node;
+                *key = heap->entries[entry].key;
+                heap->queued[*node] = false;
+                return true;
+            }
+        }
+
+        size_t bucket = 1;
+        while (bucket < RADIX_BUCKET_COUNT && heap->buckets[bucket] == PQUEUE_NONE) {
+            bucket++;
+        }
+        if (bucket == RADIX_BUCKET_COUNT) {
+            return false;
+        }
+
+        // The smallest key of the bucket becomes the last key, all its entries then
+        // differ from it in lower bits and move to lower buckets.
+        size_t list = heap->buckets[bucket];
+        heap->buckets[bucket] = PQUEUE_NONE;
+        uint64_t smallest = UINT64_MAX;
+        for (size_t entry = list; entry != PQUEUE_NONE; entry = heap->entries[entry].next) {
+            if (radix_heap_is_current(heap, entry) && heap->entries[entry].key < smallest) {
+                smallest = heap->entries[entry].key;
+            }
+        }
+        if (smallest != UINT64_MAX) {
+            heap->last = smallest;
+        }
+        while (list != PQUEUE_NONE) {
+            size_t entry = list;
+            list = heap->entries[entry].next;
+            if (radix_heap_is_current(heap, entry)) {
+                radix_heap_link(heap, entry);
+            } else {
+                radix_heap_release(heap, entry);
+            }
+        }
+    }
+}
+
+static const struct pqueue_ops binary_heap_ops = {
+    binary_heap_create, binary_heap_push, binary_heap_pop, binary_heap_destroy,
+};
+
+static const struct pqueue_ops pairing_heap_ops = {
+    pairing_heap_create, pairing_heap_push, pairing_heap_pop, pairing_heap_destroy,
+};
+
+static const struct pqueue_ops radix_heap_ops = {
+    radix_heap_create, radix_heap_push, radix_heap_pop, radix_heap_destroy,
+};
+
+bool pqueue_kind_parse(const char *name, PriorityQueueKind *kind) {
+    assert(name != NULL && kind != NULL);
+
+    if (strcmp(name, "binary") == 0) {
+        *kind = PQUEUE_BINARY_HEAP;
+    } else if (strcmp(name, "pairing") == 0) {
+        *kind = PQUEUE_PAIRING_HEAP;
+    } else if (strcmp(name, "radix") == 0) {
+        *kind = PQUEUE_RADIX_HEAP;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool pqueue_init(PriorityQueue *queue, PriorityQueueKind kind, size_t node_count, Arena *arena) {
+    assert(queue != NULL);
+
+    switch (kind) {
+        case PQUEUE_BINARY_HEAP:
+            queue->ops = &binary_heap_ops;
+            break;
+        case PQUEUE_PAIRING_HEAP:
+            queue->ops = &pairing_heap_ops;
+            break;
+        default:
+            queue->ops = &radix_heap_ops;
+            break;
+    }
+    queue->state = queue->ops->create(node_count, arena);
+
+    return queue->state != NULL;
+}
+
+bool pqueue_push(PriorityQueue *queue, size_t node, uint64_t key) {
+    assert(queue != NULL && queue->state != NULL);
+
+    return queue->ops->push(queue->state, node, key);
+}
+
+bool pqueue_pop(PriorityQueue *queue, size_t *node, uint64_t *key) {
+    assert(queue != NULL && queue->state != NULL && node != NULL && key != NULL);
+
+    return queue->ops->pop(queue->state, node, key);
+}
+
+void pqueue_destroy(PriorityQueue *queue) {
+    assert(queue != NULL);
+
+    if (queue->ops != NULL) {
+        queue->ops->destroy(queue->state);
+    }
+    queue->ops = NULL;
+    queue->state = NULL;
+}
@@ -0,0 +1,43 @@
+#ifndef PQUEUE_H
+#define PQUEUE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "arena.h"
+
+// Implementations of the priority queue, they differ only in speed.
+typedef enum PriorityQueueKind {
+    PQUEUE_BINARY_HEAP,
+    PQUEUE_PAIRING_HEAP,
+    PQUEUE_RADIX_HEAP,
+} PriorityQueueKind;
+
+struct pqueue_ops;
+
+// Min-priority queue of nodes 0 to node_count - 1 keyed by distances. Keys pushed must not be
+// smaller than the last popped key, which holds for the distances of Dijkstra's algorithm.
+typedef struct PriorityQueue {
+    const struct pqueue_ops *ops;
+    void *state;
+} PriorityQueue;
+
+// Parses the name of an implementation: "binary", "pairing" or "radix".
+bool pqueue_kind_parse(const char *name, PriorityQueueKind *kind);
+
+// Prepares an empty queue for node_count nodes, with its memory taken from the arena if it is
+// not NULL. pqueue_destroy() then leaves the memory to the arena. Returns false on allocation failure.
+bool pqueue_init(PriorityQueue *queue, PriorityQueueKind kind, size_t node_count, Arena *arena);
+
+// Queues the node with the key, or lowers its key if it is queued with a greater one.
+// Keys not smaller than the current key of the node are ignored, also after it was popped.
+// Returns false on allocation failure.
+bool pqueue_push(PriorityQueue *queue, size_t node, uint64_t key);
+
+// Removes the node with the smallest key. Returns false if the queue is empty.
+bool pqueue_pop(PriorityQueue *queue, size_t *node, uint64_t *key);
+
+// Frees the memory of the queue.
+void pqueue_destroy(PriorityQueue *queue);
+
+#endif // PQUEUE_H
@@ -0,0 +1,356 @@
+#include "route.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ROUTE_NO_NODE SIZE_MAX
+
+// One direction of a search: tentative distances and predecessors of the nodes it reached.
+struct search {
+    PriorityQueue queue;
+    uint64_t *distances;
+    size_t *previous;
+    uint64_t radius;
+    // Scratch memory of the search, NULL for the heap.
+    Arena *arena;
+};
+
+static void *route_alloc(Arena *arena, size_t size) {
+    return arena != NULL ? arena_alloc(arena, size) : malloc(size);
+}
+
+static void search_destroy(struct search *search) {
+    pqueue_destroy(&search->queue);
+    if (search->arena == NULL) {
+        free(search->distances);
+        free(search->previous);
+    }
+}
+
+static bool search_init(struct search *search, size_t node_count, PriorityQueueKind kind, Arena *arena,
+                        size_t source) {
+    memset(search, 0, sizeof(*search));
+    search->arena = arena;
+    search->distances = route_alloc(arena, node_count * sizeof(uint64_t) + 1);
+    search->previous = route_alloc(arena, node_count * sizeof(size_t) + 1);
+    if (search->distances == NULL || search->previous == NULL
+        || !pqueue_init(&search->queue, kind, node_count, arena)) {
+        search_destroy(search);
+        return false;
+    }
+
+    for (size_t node = 0; node < node_count; node++) {
+        search->distances[node] = UINT64_MAX;
+    }
+    search->distances[source] = 0;
+    search->previous[source] = ROUTE_NO_NODE;
+
+    if (!pqueue_push(&search->queue, source, 0)) {
+        search_destroy(search);
+        return false;
+    }
+    return true;
+}
+
+// Lowers the distance of the neighbor if the path through the node is shorter.
+static bool search_relax(struct search *search, size_t node, size_t neighbor, uint64_t distance) {
+    if (distance >= search->distances[neighbor]) {
+        return true;
+    }
+    search->distances[neighbor] = distance;
+    search->previous[neighbor] = node;
+    return pqueue_push(&search->queue, neighbor, distance);
+}
+
+static size_t chain_length(const size_t *previous, size_t node) {
+    size_t length = 0;
+    for (; node != ROUTE_NO_NODE; node = previous[node]) {
+        length++;
+    }
+    return length;
+}
+
+/*
+ * Stores the path from the source of the forward search to forward_end,
+ * followed by the path from backward_end to the source of the backward
+ * search, which is the target. Without a backward search, forward_end is
+ * the target. The nodes are kept with the scratch memory of the searches.
+ */
+static bool build_route(const struct search *forward, size_t forward_end, const struct search *backward,
+                        size_t backward_end, uint64_t distance, Route *route) {
+    size_t forward_count = chain_length(forward->previous, forward_end);
+    size_t backward_count = backward != NULL ? chain_length(backward->previous, backward_end) : 0;
+
+    route->count = forward_count + backward_count;
+    route->arena = forward->arena;
+    route->nodes = route_alloc(route->arena, route->count * sizeof(size_t));
+    if (route->nodes == NULL) {
+        return false;
+    }
+
+    size_t index = forward_count;
+    for (size_t node = forward_end; node != ROUTE_NO_NODE; node = forward->previous[node]) {
+        route->nodes[--index] = node;
+    }
+    index = forward_count;
+    for (size_t node = backward_end; backward != NULL && node != ROUTE_NO_NODE; node = backward->previous[node]) {
+        route->nodes[index++] = node;
+    }
+    route->distance = distance;
+
+    return true;
+}
+
+static bool find_dijkstra(const Graph *graph, size_t source, size_t target, PriorityQueueKind kind, Arena *arena,
+                          Route *route, bool *found) {
+    struct search search;
+    if (!search_init(&search, graph->node_count, kind, arena, source)) {
+        return false;
+    }
+
+    bool ok = true;
+    size_t node;
+    uint64_t distance;
+
+    // Distances only grow as nodes leave the queue, so the target is final once popped.
+    while (ok && pqueue_pop(&search.queue, &node, &distance)) {
+        if (node == target) {
+            *found = true;
+            ok = build_route(&search, target, NULL, ROUTE_NO_NODE, distance, route);
+            break;
+        }
+
+        for (size_t k = graph->offsets[node]; k < graph->offsets[node + 1] && ok; k++) {
+            ok = search_relax(&search, node, graph->targets[k], distance + graph->weights[k]);
+        }
+    }
+
+    search_destroy(&search);
+    return ok;
+}
+
+/*
+ * Searches from both ends at once, the graph is undirected so the backward
+ * search uses the same adjacency. Every edge between nodes reached from both
+ * sides gives a candidate path. Once the radii of the two searches add up to
+ * the best candidate, no unseen path can be shorter.
+ */
+static bool find_bidirectional(const Graph *graph, size_t source, size_t target, PriorityQueueKind kind,
+                               Arena *arena, Route *route, bool *found) {
+    struct search searches[2];
+    if (!search_init(&searches[0], graph->node_count, kind, arena, source)) {
+        return false;
+    }
+    if (!search_init(&searches[1], graph->node_count, kind, arena, target)) {
+        search_destroy(&searches[0]);
+        return false;
+    }
+
+    bool ok = true;
+    uint64_t best = UINT64_MAX;
+    size_t meet[2] = { ROUTE_NO_NODE, ROUTE_NO_NODE };
+
+    while (ok) {
+        // Grow the smaller of the two balls.
+        int side = searches[0].radius <= searches[1].radius ? 0 : 1;
+        struct search *search = &searches[side];
+        const struct search *other = &searches[1 - side];
+        size_t node;
+        uint64_t distance;
+
+        if (!pqueue_pop(&search->queue, &node, &distance) || distance + other->radius >= best) {
+            break;
+        }
+        search->radius = distance;
+
+        for (size_t k = graph->offsets[node]; k < graph->offsets[node + 1] && ok; k++) {
+            size_t neighbor = graph->targets[k];
+            uint64_t neighbor_distance = distance + graph->weights[k];
+
+            if (other->distances[neighbor] != UINT64_MAX && neighbor_distance + other->distances[neighbor] < best) {
+                best = neighbor_distance + other->distances[neighbor];
+                meet[side] = node;
+                meet[1 - side] = neighbor;
+            }
+            ok = search_relax(search, node, neighbor, neighbor_distance);
+        }
+    }
+
+    if (ok && best != UINT64_MAX) {
+        *found = true;
+        ok = build_route(&searches[0], meet[0], &searches[1], meet[1], best, route);
+    }
+
+    search_destroy(&searches[0]);
+    search_destroy(&searches[1]);
+    return ok;
+}
+
+/*
+ * Searches the hierarchy upward from both ends, so each side only settles
+ * nodes of growing rank. The shortest path meets at its highest ranked node,
+ * which both sides settle unless their radius already reached the best
+ * meeting. The found path is then unpacked into the nodes of the graph.
+ */
+static bool find_hierarchy(const ContractionHierarchy *hierarchy, size_t source, size_t target,
+                           PriorityQueueKind kind, Arena *arena, Route *route, bool *found) {
+    struct search searches[2];
+    if (!search_init(&searches[0], hierarchy->node_count, kind, arena, source)) {
+        return false;
+    }
+    if (!search_init(&searches[1], hierarchy->node_count, kind, arena, target)) {
+        search_destroy(&searches[0]);
+        return false;
+    }
+
+    bool ok = true;
+    bool finished[2] = { false, false };
+    uint64_t best = UINT64_MAX;
+    size_t meet = ROUTE_NO_NODE;
+
+    while (ok && !(finished[0] && finished[1])) {
+        int side = finished[0] ? 1 : finished[1] ? 0 : searches[0].radius <= searches[1].radius ? 0 : 1;
+        struct search *search = &searches[side];
+        const struct search *other = &searches[1 - side];
+        size_t node;
+        uint64_t distance;
+
+        if (!pqueue_pop(&search->queue, &node, &distance) || distance >= best) {
+            finished[side] = true;
+            continue;
+        }
+        search->radius = distance;
+
+        if (other->distances[node] != UINT64_MAX && distance + other->distances[node] < best) {
+            best = distance + other->distances[node];
+            meet = node;
+        }
+        for (size_t k = hierarchy->offsets[node]; k < hierarchy->offsets[node + 1] && ok; k++) {
+            ok = search_relax(search, node, hierarchy->targets[k], distance + hierarchy->weights[k]);
+        }
+    }
+
+    Route packed;
+    memset(&packed, 0, sizeof(packed));
+    if (ok && meet != ROUTE_NO_NODE) {
+        ok = build_route(&searches[0], meet, &searches[1], searches[1].previous[meet], best, &packed);
+        if (ok) {
+            *found = true;
+            route->distance = packed.distance;
+            ok = hierarchy_unpack(hierarchy, packed.nodes, packed.count, &route->nodes, &route->count);
+        }
+    }
+
+    route_destroy(&packed);
+    search_destroy(&searches[0]);
+    search_destroy(&searches[1]);
+    return ok;
+}
+
+/*
+ * A* search guided by the landmark bounds. Queue keys are the distance from
+ * the source plus the bound of the rest, and the bounds are consistent, so
+ * the target is final once popped like in Dijkstra's algorithm. Nodes not
+ * connected to the target are never queued.
+ */
+static bool find_alt(const Graph *graph, const Landmarks *landmarks, size_t source, size_t target,
+                     PriorityQueueKind kind, Arena *arena, Route *route, bool *found) {
+    struct search search;
+    if (!search_init(&search, graph->node_count, kind, arena, source)) {
+        return false;
+    }
+
+    bool ok = true;
+    size_t node;
+    uint64_t key;
+
+    while (ok && pqueue_pop(&search.queue, &node, &key)) {
+        uint64_t distance = search.distances[node];
+        if (node == target) {
+            *found = true;
+            ok = build_route(&search, target, NULL, ROUTE_NO_NODE, distance, route);
+            break;
+        }
+
+        for (size_t k = graph->offsets[node]; k < graph->offsets[node + 1] && ok; k++) {
+            size_t neighbor = graph->targets[k];
+            uint64_t neighbor_distance = distance + graph->weights[k];
+            if (neighbor_distance >= search.distances[neighbor]) {
+                continue;
+            }
+
+            uint64_t bound = landmarks_lower_bound(landmarks, neighbor, target);
+            if (bound != LANDMARKS_UNREACHABLE) {
+                search.distances[neighbor] = neighbor_distance;
+                search.previous[neighbor] = node;
+                ok = pqueue_push(&search.queue, neighbor, neighbor_distance + bound);
+            }
+        }
+    }
+
+    search_destroy(&search);
+    return ok;
+}
+
+bool route_algorithm_parse(const char *name, RouteAlgorithm *algorithm) {
+    assert(name != NULL && algorithm != NULL);
+
+    if (strcmp(name, "dijkstra") == 0) {
+        *algorithm = ROUTE_DIJKSTRA;
+    } else if (strcmp(name, "bidirectional") == 0) {
+        *algorithm = ROUTE_BIDIRECTIONAL;
+    } else if (strcmp(name, "ch") == 0) {
+        *algorithm = ROUTE_CONTRACTION_HIERARCHY;
+    } else if (strcmp(name, "alt") == 0) {
+        *algorithm = ROUTE_LANDMARKS;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool route_find(const Graph *graph, size_t source, size_t target, const RouteOptions *options, Route *route,
+                bool *found) {
+    assert(graph != NULL && options != NULL && route != NULL && found != NULL);
+    assert(source < graph->node_count && target < graph->node_count);
+
+    memset(route, 0, sizeof(*route));
+    *found = false;
+
+    if (source == target) {
+        route->arena = options->scratch;
+        route->nodes = route_alloc(route->arena, sizeof(size_t));
+        if (route->nodes == NULL) {
+            return false;
+        }
+        route->nodes[0] = source;
+        route->count = 1;
+        *found = true;
+        return true;
+    }
+
+    switch (options->algorithm) {
+        case ROUTE_BIDIRECTIONAL:
+            return find_bidirectional(graph, source, target, options->queue, options->scratch, route, found);
+        case ROUTE_CONTRACTION_HIERARCHY:
+            assert(options->hierarchy != NULL && options->hierarchy->node_count == graph->node_count);
+            return find_hierarchy(options->hierarchy, source, target, options->queue, options->scratch, route,
+                                  found);
+        case ROUTE_LANDMARKS:
+            assert(options->landmarks != NULL && options->landmarks->node_count == graph->node_count);
+            return find_alt(graph, options->landmarks, source, target, options->queue, options->scratch, route,
+                            found);
+        default:
+            return find_dijkstra(graph, source, target, options->queue, options->scratch, route, found);
+    }
+}
+
+void route_destroy(Route *route) {
+    assert(route != NULL);
+
+    if (route->arena == NULL) {
+        free(route->nodes);
+    }
+    memset(route, 0, sizeof(*route));
+}
@@ -0,0 +1,54 @@
+#ifndef ROUTE_H
+#define ROUTE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "arena.h"
+#include "graph.h"
+#include "hierarchy.h"
+#include "landmarks.h"
+#include "pqueue.h"
+
+// Algorithms of the route search, they differ only in speed.
+typedef enum RouteAlgorithm {
+    ROUTE_DIJKSTRA,
+    ROUTE_BIDIRECTIONAL,
+    ROUTE_CONTRACTION_HIERARCHY,
+    ROUTE_LANDMARKS,
+} RouteAlgorithm;
+
+// How to search for a route. ROUTE_CONTRACTION_HIERARCHY needs the hierarchy of the graph,
+// ROUTE_LANDMARKS its landmarks. With a scratch arena, the search takes its memory from it
+// instead of the heap and leaves it there.
+typedef struct RouteOptions {
+    RouteAlgorithm algorithm;
+    PriorityQueueKind queue;
+    const ContractionHierarchy *hierarchy;
+    const Landmarks *landmarks;
+    Arena *scratch;
+} RouteOptions;
+
+// Shortest path between two nodes of a graph, from the source to the target.
+typedef struct Route {
+    size_t *nodes;
+    size_t count;
+    uint64_t distance;
+    // Arena holding the nodes, NULL if they are on the heap.
+    Arena *arena;
+} Route;
+
+// Parses the name of an algorithm: "dijkstra", "bidirectional", "ch" or "alt".
+bool route_algorithm_parse(const char *name, RouteAlgorithm *algorithm);
+
+// Finds the shortest path from source to target with Dijkstra's algorithm, searching from
+// the source only, from both ends, upward in the contraction hierarchy, or as A* with
+// landmark bounds. found is false when no path exists. Returns false on
+// allocation failure.
+bool route_find(const Graph *graph, size_t source, size_t target, const RouteOptions *options, Route *route,
+                bool *found);
+
+// Frees the memory of the route, unless an arena holds it.
+void route_destroy(Route *route);
+
+#endif // ROUTE_H
@@ -0,0 +1,394 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "server.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include "arena.h"
+#include "batch.h"
+#include "data_source.h"
+
+#define SERVER_BACKLOG 64
+#define SERVER_QUEUE_SIZE 256
+#define SERVER_BUFFER_SIZE (64 * 1024)
+#define SERVER_SCRATCH_CHUNK_SIZE (1024 * 1024)
+
+// Seconds between the checks of the input files for changes.
+#define SERVER_WATCH_INTERVAL 2
+
+// Bytes the signal handlers write to the event pipe.
+#define SERVER_EVENT_STOP 's'
+#define SERVER_EVENT_RELOAD 'r'
+
+struct server;
+
+struct server_worker {
+    pthread_t thread;
+    struct server *server;
+    // Connection being served, -1 when idle.
+    int client;
+    char input_buffer[SERVER_BUFFER_SIZE];
+    char output_buffer[SERVER_BUFFER_SIZE];
+    // Scratch memory of one command, reset once it is answered. It keeps the size
+    // of the largest command, so the next ones allocate nothing.
+    Arena scratch;
+};
+
+struct server {
+    DataSource *source;
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    int pending[SERVER_QUEUE_SIZE];
+    size_t first_pending;
+    size_t pending_count;
+    bool stopping;
+    struct server_worker *workers;
+    size_t worker_count;
+
+    // At most one reload runs at a time, on its own thread.
+    pthread_t reloader;
+    bool reloader_started;
+    bool reloading;
+};
+
+// Write end of the pipe that wakes the accepting thread up when a signal arrives.
+static volatile sig_atomic_t event_pipe = -1;
+
+static void signal_event(int signal_number) {
+    int saved_errno = errno;
+    if (event_pipe != -1) {
+        char event = signal_number == SIGHUP ? SERVER_EVENT_RELOAD : SERVER_EVENT_STOP;
+        ssize_t written = write(event_pipe, &event, 1);
+        (void) written;
+    }
+    errno = saved_errno;
+}
+
+/*
+ * Reads the commands of one connection with its own pair of streams. The
+ * buffers are large enough for most results, so a response usually leaves
+ * in a single write when run_batch() flushes it.
+ */
+static void serve_client(struct server_worker *worker, int client) {
+    int output_fd = dup(client);
+    FILE *input = fdopen(client, "r");
+    FILE *output = output_fd != -1 ? fdopen(output_fd, "w") : NULL;
+
+    if (input != NULL && output != NULL) {
+        setvbuf(input, worker->input_buffer, _IOFBF, SERVER_BUFFER_SIZE);
+        setvbuf(output, worker->output_buffer, _IOFBF, SERVER_BUFFER_SIZE);
+        run_batch(worker->server->source, input, output, &worker->scratch);
+    }
+
+    // The stopping server may shut the connection down until it is no longer listed.
+    pthread_mutex_lock(&worker->server->lock);
+    worker->client = -1;
+    pthread_mutex_unlock(&worker->server->lock);
+
+    if (input != NULL) {
+        fclose(input);
+    } else {
+        close(client);
+    }
+    if (output != NULL) {
+        fclose(output);
+    } else if (output_fd != -1) {
+        close(output_fd);
+    }
+}
+
+static void *run_worker(void *arg) {
+    struct server_worker *worker = arg;
+    struct server *server = worker->server;
+
+    pthread_mutex_lock(&server->lock);
+    while (!server->stopping) {
+        if (server->pending_count == 0) {
+            pthread_cond_wait(&server->changed, &server->lock);
+            continue;
+        }
+
+        int client = server->pending[server->first_pending];
+        server->first_pending = (server->first_pending + 1) % SERVER_QUEUE_SIZE;
+        server->pending_count--;
+        worker->client = client;
+        pthread_mutex_unlock(&server->lock);
+
+        serve_client(worker, client);
+
+        pthread_mutex_lock(&server->lock);
+    }
+    pthread_mutex_unlock(&server->lock);
+
+    arena_free(&worker->scratch);
+    return NULL;
+}
+
+// Returns the listening socket bound to the path, or -1. A socket left at the path by a
+// previous run is replaced, any other file is kept.
+static int open_socket(const char *socket_path) {
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strlen(socket_path) >= sizeof(address.sun_path)) {
+        fprintf(stderr, "Socket path is too long\n");
+        return -1;
+    }
+    strcpy(address.sun_path, socket_path);
+
+    struct stat status;
+    if (stat(socket_path, &status) == 0 && S_ISSOCK(status.st_mode)) {
+        unlink(socket_path);
+    }
+
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener == -1) {
+        return -1;
+    }
+    if (bind(listener, (struct sockaddr *) &address, sizeof(address)) == -1
+        || listen(listener, SERVER_BACKLOG) == -1) {
+        close(listener);
+        return -1;
+    }
+    return listener;
+}
+
+/*
+ * Queues the accepted connection for the workers. A connection arriving
+ * while the queue is full is closed right away: the accepting thread is the
+ * only one reading the signal events and watching the input files, so it
+ * must never wait for a worker.
+ */
+static bool queue_client(struct server *server, int client) {
+    pthread_mutex_lock(&server->lock);
+    bool queued = server->pending_count < SERVER_QUEUE_SIZE;
+    if (queued) {
+        server->pending[(server->first_pending + server->pending_count) % SERVER_QUEUE_SIZE] = client;
+        server->pending_count++;
+        pthread_cond_broadcast(&server->changed);
+    }
+    pthread_mutex_unlock(&server->lock);
+
+    if (!queued) {
+        close(client);
+    }
+    return queued;
+}
+
+static void *run_reload(void *arg) {
+    struct server *server = arg;
+
+    if (data_source_reload(server->source)) {
+        data_source_pin(server->source);
+        fprintf(stderr, "Reloaded the input files as version %lu\n", data_source_version(server->source));
+        data_source_unpin(server->source);
+    } else {
+        fprintf(stderr, "Failed to reload the input files, keeping the previous data\n");
+    }
+
+    pthread_mutex_lock(&server->lock);
+    server->reloading = false;
+    pthread_mutex_unlock(&server->lock);
+    return NULL;
+}
+
+// Starts a reload in the background unless one is running already.
+static void start_reload(struct server *server) {
+    pthread_mutex_lock(&server->lock);
+    bool busy = server->reloading;
+    server->reloading = true;
+    pthread_mutex_unlock(&server->lock);
+    if (busy) {
+        return;
+    }
+
+    if (server->reloader_started) {
+        pthread_join(server->reloader, NULL);
+    }
+    server->reloader_started = pthread_create(&server->reloader, NULL, run_reload, server) == 0;
+    if (!server->reloader_started) {
+        pthread_mutex_lock(&server->lock);
+        server->reloading = false;
+        pthread_mutex_unlock(&server->lock);
+    }
+}
+
+// Reads the pending signal events, returns true if one asks to stop.
+static bool read_events(int event_reader, bool *reload) {
+    char events[64];
+    ssize_t count;
+    while ((count = read(event_reader, events, sizeof(events))) > 0) {
+        for (ssize_t index = 0; index < count; index++) {
+            if (events[index] == SERVER_EVENT_STOP) {
+                return true;
+            }
+            *reload = true;
+        }
+    }
+    return false;
+}
+
+/*
+ * Waits for connections and for the event pipe at once. The signal handlers
+ * write to the pipe, so a signal arriving at any moment, even right before
+ * select(), ends the wait. The wait also times out now and then to look for
+ * changed input files.
+ */
+static void accept_clients(struct server *server, int listener, int event_reader) {
+    int highest = listener > event_reader ? listener : event_reader;
+    time_t next_check = time(NULL) + SERVER_WATCH_INTERVAL;
+
+    for (;;) {
+        fd_set readable;
+        FD_ZERO(&readable);
+        FD_SET(listener, &readable);
+        FD_SET(event_reader, &readable);
+        struct timeval timeout = { SERVER_WATCH_INTERVAL, 0 };
+
+        int ready = select(highest + 1, &readable, NULL, NULL, &timeout);
+        if (ready == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("Failed to wait for clients");
+            return;
+        }
+
+        bool reload = false;
+        if (time(NULL) >= next_check) {
+            reload = data_source_changed(server->source);
+            next_check = time(NULL) + SERVER_WATCH_INTERVAL;
+        }
+        if (ready > 0 && FD_ISSET(event_reader, &readable) && read_events(event_reader, &reload)) {
+            return;
+        }
+        if (reload) {
+            start_reload(server);
+        }
+        if (ready == 0 || !FD_ISSET(listener, &readable)) {
+            continue;
+        }
+
+        int client = accept(listener, NULL, NULL);
+        if (client != -1) {
+            if (!queue_client(server, client)) {
+                fprintf(stderr, "Refused a client, all workers are busy and the queue is full\n");
+            }
+        } else if (errno != EINTR && errno != ECONNABORTED) {
+            perror("Failed to accept a client");
+            return;
+        }
+    }
+}
+
+// Wakes the workers up, ends the connections in progress and waits for the workers to finish.
+static void stop_workers(struct server *server, size_t started) {
+    pthread_mutex_lock(&server->lock);
+    server->stopping = true;
+    for (size_t index = 0; index < started; index++) {
+        if (server->workers[index].client != -1) {
+            shutdown(server->workers[index].client, SHUT_RDWR);
+        }
+    }
+    pthread_cond_broadcast(&server->changed);
+    pthread_mutex_unlock(&server->lock);
+
+    for (size_t index = 0; index < started; index++) {
+        pthread_join(server->workers[index].thread, NULL);
+    }
+    for (; server->pending_count > 0; server->pending_count--) {
+        close(server->pending[server->first_pending]);
+        server->first_pending = (server->first_pending + 1) % SERVER_QUEUE_SIZE;
+    }
+}
+
+bool run_server(DataSource *source, const char *socket_path, size_t worker_count) {
+    assert(source != NULL && socket_path != NULL && worker_count > 0);
+
+    struct server server;
+    memset(&server, 0, sizeof(server));
+    server.source = source;
+    server.workers = calloc(worker_count, sizeof(struct server_worker));
+    if (server.workers == NULL) {
+        return false;
+    }
+    int listener = open_socket(socket_path);
+    if (listener == -1) {
+        perror("Failed to open the socket");
+        free(server.workers);
+        return false;
+    }
+    int event_fds[2];
+    // Repeated signals must not block the handler once the pipe is full, nor reading it once it is empty.
+    if (pipe(event_fds) == -1 || fcntl(event_fds[0], F_SETFL, O_NONBLOCK) == -1
+        || fcntl(event_fds[1], F_SETFL, O_NONBLOCK) == -1) {
+        perror("Failed to create the event pipe");
+        close(listener);
+        unlink(socket_path);
+        free(server.workers);
+        return false;
+    }
+    pthread_mutex_init(&server.lock, NULL);
+    pthread_cond_init(&server.changed, NULL);
+
+    struct sigaction event_action, ignore_action, old_int, old_term, old_hup, old_pipe;
+    memset(&event_action, 0, sizeof(event_action));
+    event_action.sa_handler = signal_event;
+    sigemptyset(&event_action.sa_mask);
+    memset(&ignore_action, 0, sizeof(ignore_action));
+    ignore_action.sa_handler = SIG_IGN;
+    sigemptyset(&ignore_action.sa_mask);
+    event_pipe = event_fds[1];
+    // A client that leaves early must not kill the server with SIGPIPE.
+    sigaction(SIGPIPE, &ignore_action, &old_pipe);
+    sigaction(SIGINT, &event_action, &old_int);
+    sigaction(SIGTERM, &event_action, &old_term);
+    sigaction(SIGHUP, &event_action, &old_hup);
+
+    size_t started = 0;
+    for (; started < worker_count; started++) {
+        struct server_worker *worker = &server.workers[started];
+        worker->server = &server;
+        worker->client = -1;
+        arena_init(&worker->scratch, SERVER_SCRATCH_CHUNK_SIZE);
+        if (pthread_create(&worker->thread, NULL, run_worker, worker) != 0) {
+            break;
+        }
+    }
+
+    bool ok = started > 0;
+    if (ok) {
+        accept_clients(&server, listener, event_fds[0]);
+    }
+    stop_workers(&server, started);
+    if (server.reloader_started) {
+        pthread_join(server.reloader, NULL);
+    }
+
+    close(listener);
+    unlink(socket_path);
+    sigaction(SIGINT, &old_int, NULL);
+    sigaction(SIGTERM, &old_term, NULL);
+    sigaction(SIGHUP, &old_hup, NULL);
+    sigaction(SIGPIPE, &old_pipe, NULL);
+    event_pipe = -1;
+    close(event_fds[0]);
+    close(event_fds[1]);
+    pthread_cond_destroy(&server.changed);
+    pthread_mutex_destroy(&server.lock);
+    free(server.workers);
+    return ok;
+}
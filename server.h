@@ -0,0 +1,16 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "data_source.h"
+
+// Serves the commands of run_batch() over a Unix domain socket created at the path, until
+// SIGINT or SIGTERM arrives. Every connection is a batch of its own, handled by one of
+// worker_count threads sharing the data source. Connections wait in a bounded queue while
+// every worker is busy, and ones arriving when it is full are closed at once. SIGHUP or a
+// change of the input files reloads them in the background. Returns false if the socket
+// cannot be set up.
+bool run_server(DataSource *source, const char *socket_path, size_t worker_count);
+
+#endif // SERVER_H
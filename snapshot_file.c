@@ -0,0 +1,599 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "snapshot_file.h"
+
+#include <assert.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define SNAPSHOT_MAGIC "GCSNAP\r\n"
+#define SNAPSHOT_FORMAT_VERSION 3
+
+// Every section starts at a multiple of this, enough for all the column types.
+#define SNAPSHOT_ALIGNMENT 8
+
+#define SNAPSHOT_CONTAINER_COLUMNS 9
+#define SNAPSHOT_PATH_COLUMNS 3
+
+/*
+ * The file is the header followed by the sections listed below, in this
+ * order, each padded to SNAPSHOT_ALIGNMENT. Every number is little-endian
+ * and sections hold the columns exactly as they are in memory, so a mapped
+ * file is used in place. The lengths of the sections follow from the counts
+ * in the header.
+ *
+ * The payload checksum covers the sections and is only verified on request,
+ * as it reads the whole file. Mapping checks the header and the indices the
+ * sections refer to each other by instead, see sections_valid().
+ */
+struct snapshot_header {
+    char magic[8];
+    uint32_t format_version;
+    uint32_t size_t_size;
+    SnapshotSource sources[2];
+    uint64_t container_count;
+    uint64_t path_count;
+    uint64_t station_count;
+    uint64_t container_edge_count;
+    uint64_t station_edge_count;
+    uint64_t hierarchy_edge_count;
+    uint64_t string_count;
+    uint64_t string_bytes;
+    uint64_t index_capacity;
+    uint64_t container_text_size;
+    uint64_t path_text_size;
+    uint64_t payload_checksum;
+    // Checksum of all the fields above.
+    uint64_t header_checksum;
+};
+
+// X(field of SnapshotData, number of its elements)
+#define SNAPSHOT_SECTIONS(X) \
+    X(containers.id, header->container_count) \
+    X(containers.x, header->container_count) \
+    X(containers.y, header->container_count) \
+    X(containers.x_key, header->container_count) \
+    X(containers.y_key, header->container_count) \
+    X(containers.capacity, header->container_count) \
+    X(containers.waste_type, header->container_count) \
+    X(containers.is_public, header->container_count) \
+    X(containers.name, header->container_count) \
+    X(containers.street, header->container_count) \
+    X(containers.number, header->container_count) \
+    X(containers.strings.data, header->string_bytes) \
+    X(containers.strings.offsets, header->string_count) \
+    X(index.keys, header->index_capacity) \
+    X(index.rows, header->index_capacity) \
+    X(paths.a_id, header->path_count) \
+    X(paths.b_id, header->path_count) \
+    X(paths.distance, header->path_count) \
+    X(paths.a_row, header->path_count) \
+    X(paths.b_row, header->path_count) \
+    X(container_graph.offsets, header->container_count + 1) \
+    X(container_graph.targets, header->container_edge_count) \
+    X(container_graph.weights, header->container_edge_count) \
+    X(stations.waste_types, header->station_count) \
+    X(stations.capacity, header->station_count) \
+    X(stations.container_offsets, header->station_count + 1) \
+    X(stations.containers, header->container_count) \
+    X(stations.station_of, header->container_count) \
+    X(stations.graph.offsets, header->station_count + 1) \
+    X(stations.graph.targets, header->station_edge_count) \
+    X(stations.graph.weights, header->station_edge_count) \
+    X(hierarchy.rank, header->station_count) \
+    X(hierarchy.offsets, header->station_count + 1) \
+    X(hierarchy.targets, header->hierarchy_edge_count) \
+    X(hierarchy.weights, header->hierarchy_edge_count) \
+    X(hierarchy.middles, header->hierarchy_edge_count) \
+    X(container_fields.offsets, header->container_count * SNAPSHOT_CONTAINER_COLUMNS) \
+    X(container_fields.text, header->container_text_size) \
+    X(path_fields.offsets, header->path_count * SNAPSHOT_PATH_COLUMNS) \
+    X(path_fields.text, header->path_text_size)
+
+static bool platform_supported(void) {
+    const uint16_t probe = 1;
+    return *(const unsigned char *) &probe == 1 && sizeof(size_t) == sizeof(uint64_t) && sizeof(bool) == 1;
+}
+
+#define CHECKSUM_START 14695981039346656037ULL
+#define CHECKSUM_PRIME 1099511628211ULL
+
+// FNV-1a
+static uint64_t checksum_update(uint64_t hash, const void *data, size_t size) {
+    const unsigned char *bytes = data;
+    for (size_t index = 0; index < size; index++) {
+        hash ^= bytes[index];
+        hash *= CHECKSUM_PRIME;
+    }
+    return hash;
+}
+
+// FNV-1a taking 64-bit words instead of bytes, a partial last word is padded with zeros the
+// same way as the section in the file.
+static uint64_t checksum_words(uint64_t hash, const void *data, size_t size) {
+    const unsigned char *bytes = data;
+    size_t whole = size / sizeof(uint64_t) * sizeof(uint64_t);
+    uint64_t word;
+    for (size_t offset = 0; offset < whole; offset += sizeof(uint64_t)) {
+        memcpy(&word, bytes + offset, sizeof(word));
+        hash = (hash ^ word) * CHECKSUM_PRIME;
+    }
+    if (whole < size) {
+        word = 0;
+        memcpy(&word, bytes + whole, size - whole);
+        hash = (hash ^ word) * CHECKSUM_PRIME;
+    }
+    return hash;
+}
+
+static uint64_t header_checksum(const struct snapshot_header *header) {
+    return checksum_update(CHECKSUM_START, header, offsetof(struct snapshot_header, header_checksum));
+}
+
+static uint64_t aligned(uint64_t size) {
+    return (size + SNAPSHOT_ALIGNMENT - 1) / SNAPSHOT_ALIGNMENT * SNAPSHOT_ALIGNMENT;
+}
+
+// Returns the size of the file described by the header, or 0 if the counts overflow it.
+static uint64_t expected_file_size(const struct snapshot_header *header) {
+    const SnapshotData *data = NULL;
+    uint64_t size = sizeof(struct snapshot_header);
+    bool overflow = false;
+
+#define ADD_SECTION_SIZE(field, count) \
+    overflow |= (count) > (UINT64_MAX / 2 - size) / sizeof(*data->field); \
+    if (!overflow) { \
+        size = aligned(size + (count) * sizeof(*data->field)); \
+    }
+    SNAPSHOT_SECTIONS(ADD_SECTION_SIZE)
+#undef ADD_SECTION_SIZE
+
+    return overflow ? 0 : size;
+}
+
+bool snapshot_source_read(const char *path, SnapshotSource *source) {
+    struct stat status;
+    if (stat(path, &status) == -1) {
+        return false;
+    }
+
+    source->size = (uint64_t) status.st_size;
+    source->modified_seconds = (int64_t) status.st_mtim.tv_sec;
+    source->modified_nanoseconds = (int64_t) status.st_mtim.tv_nsec;
+    return true;
+}
+
+// Lays the fields out as offsets into one text, the way they are stored in the file.
+static bool flatten_fields(const SnapshotFields *fields, SnapshotFields *flat, uint64_t **offsets, char **text) {
+    *flat = *fields;
+    *offsets = NULL;
+    *text = NULL;
+    if (fields->lines == NULL) {
+        return true;
+    }
+
+    size_t field_count = fields->row_count * fields->column_count;
+    size_t text_size = 0;
+    for (size_t row = 0; row < fields->row_count; row++) {
+        for (size_t column = 0; column < fields->column_count; column++) {
+            text_size += strlen(fields->lines[row][column]) + 1;
+        }
+    }
+
+    *offsets = malloc(field_count * sizeof(uint64_t) + 1);
+    *text = malloc(text_size + 1);
+    if (*offsets == NULL || *text == NULL) {
+        free(*offsets);
+        free(*text);
+        return false;
+    }
+
+    size_t used = 0;
+    for (size_t row = 0; row < fields->row_count; row++) {
+        for (size_t column = 0; column < fields->column_count; column++) {
+            size_t length = strlen(fields->lines[row][column]) + 1;
+            (*offsets)[row * fields->column_count + column] = used;
+            memcpy(*text + used, fields->lines[row][column], length);
+            used += length;
+        }
+    }
+
+    flat->lines = NULL;
+    flat->offsets = *offsets;
+    flat->text = *text;
+    flat->text_size = text_size;
+    return true;
+}
+
+static bool write_section(FILE *file, const void *data, size_t size, uint64_t *checksum) {
+    static const char padding[SNAPSHOT_ALIGNMENT];
+    size_t padding_size = (size_t) (aligned(size) - size);
+
+    if ((size > 0 && fwrite(data, 1, size, file) != size)
+        || (padding_size > 0 && fwrite(padding, 1, padding_size, file) != padding_size)) {
+        return false;
+    }
+    *checksum = checksum_words(*checksum, data, size);
+    return true;
+}
+
+static bool write_file(FILE *file, const SnapshotData *data, struct snapshot_header *header) {
+    // The header is written again once the checksum of the sections is known.
+    if (fwrite(header, sizeof(*header), 1, file) != 1) {
+        return false;
+    }
+
+    bool ok = true;
+    uint64_t checksum = CHECKSUM_START;
+#define WRITE_SECTION(field, count) \
+    ok = ok && write_section(file, data->field, (size_t) ((count) * sizeof(*data->field)), &checksum);
+    SNAPSHOT_SECTIONS(WRITE_SECTION)
+#undef WRITE_SECTION
+
+    header->payload_checksum = checksum;
+    header->header_checksum = header_checksum(header);
+    return ok && fseek(file, 0, SEEK_SET) == 0 && fwrite(header, sizeof(*header), 1, file) == 1
+           && fflush(file) == 0;
+}
+
+// Writes the whole snapshot to the file, which must be empty and seekable.
+static bool write_snapshot(FILE *file, const SnapshotData *data, const SnapshotSource sources[2]) {
+    assert(data->container_fields.column_count == SNAPSHOT_CONTAINER_COLUMNS
+           && data->path_fields.column_count == SNAPSHOT_PATH_COLUMNS
+           && data->hierarchy.node_count == data->stations.count);
+
+    SnapshotData flat = *data;
+    uint64_t *offsets[2];
+    char *texts[2];
+    if (!flatten_fields(&data->container_fields, &flat.container_fields, &offsets[0], &texts[0])) {
+        return false;
+    }
+    if (!flatten_fields(&data->path_fields, &flat.path_fields, &offsets[1], &texts[1])) {
+        free(offsets[0]);
+        free(texts[0]);
+        return false;
+    }
+
+    struct snapshot_header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.format_version = SNAPSHOT_FORMAT_VERSION;
+    header.size_t_size = sizeof(size_t);
+    header.sources[0] = sources[0];
+    header.sources[1] = sources[1];
+    header.container_count = flat.containers.count;
+    header.path_count = flat.paths.count;
+    header.station_count = flat.stations.count;
+    header.container_edge_count = flat.container_graph.offsets[flat.container_graph.node_count];
+    header.station_edge_count = flat.stations.graph.offsets[flat.stations.graph.node_count];
+    header.hierarchy_edge_count = flat.hierarchy.offsets[flat.hierarchy.node_count];
+    header.string_count = flat.containers.strings.count;
+    header.string_bytes = flat.containers.strings.size;
+    header.index_capacity = flat.index.capacity;
+    header.container_text_size = flat.container_fields.text_size;
+    header.path_text_size = flat.path_fields.text_size;
+
+    bool ok = write_file(file, &flat, &header);
+    for (size_t index = 0; index < 2; index++) {
+        free(offsets[index]);
+        free(texts[index]);
+    }
+    return ok;
+}
+
+bool snapshot_file_write(const char *path, const SnapshotData *data, const SnapshotSource sources[2]) {
+    assert(path != NULL && data != NULL && sources != NULL);
+
+    if (!platform_supported()) {
+        return false;
+    }
+
+    // Readers may still map the previous file, so the new one replaces it by a rename.
+    size_t path_length = strlen(path);
+    char *temporary_path = malloc(path_length + sizeof(".XXXXXX"));
+    int fd = -1;
+    if (temporary_path != NULL) {
+        memcpy(temporary_path, path, path_length);
+        memcpy(temporary_path + path_length, ".XXXXXX", sizeof(".XXXXXX"));
+        fd = mkstemp(temporary_path);
+    }
+    FILE *file = fd != -1 ? fdopen(fd, "wb") : NULL;
+
+    // mkstemp() leaves the file private to the owner, the CSV files it replaces are not.
+    bool ok = file != NULL && fchmod(fd, 0644) == 0 && write_snapshot(file, data, sources) && fsync(fd) == 0;
+    if (file != NULL) {
+        ok = fclose(file) == 0 && ok;
+    } else if (fd != -1) {
+        close(fd);
+    }
+    if (fd != -1) {
+        ok = ok && rename(temporary_path, path) == 0;
+        if (!ok) {
+            unlink(temporary_path);
+        }
+    }
+
+    free(temporary_path);
+    return ok;
+}
+
+/*
+ * Shared memory objects cannot be renamed, so the previous object is
+ * unlinked first. Processes that attached to it keep their mapping, and
+ * one attaching while the new object is written finds the header without
+ * its checksum, which is only written after all the sections.
+ */
+bool snapshot_shm_write(const char *name, const SnapshotData *data, const SnapshotSource sources[2]) {
+    assert(name != NULL && data != NULL && sources != NULL);
+
+    if (!platform_supported()) {
+        return false;
+    }
+
+    shm_unlink(name);
+    int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd == -1) {
+        return false;
+    }
+    FILE *file = fdopen(fd, "wb");
+
+    bool ok = file != NULL && write_snapshot(file, data, sources);
+    if (file != NULL) {
+        ok = fclose(file) == 0 && ok;
+    } else {
+        close(fd);
+    }
+    if (!ok) {
+        shm_unlink(name);
+    }
+    return ok;
+}
+
+bool snapshot_shm_remove(const char *name) {
+    assert(name != NULL);
+
+    return shm_unlink(name) == 0;
+}
+
+static bool same_source(const SnapshotSource *a, const SnapshotSource *b) {
+    return a->size == b->size && a->modified_seconds == b->modified_seconds
+           && a->modified_nanoseconds == b->modified_nanoseconds;
+}
+
+static bool header_valid(const struct snapshot_header *header, size_t file_size, const SnapshotSource sources[2]) {
+    return memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) == 0
+           && header->format_version == SNAPSHOT_FORMAT_VERSION && header->size_t_size == sizeof(size_t)
+           && header->header_checksum == header_checksum(header) && header->string_count <= UINT32_MAX
+           && same_source(&header->sources[0], &sources[0]) && same_source(&header->sources[1], &sources[1])
+           && expected_file_size(header) == file_size;
+}
+
+// Tells whether every index is below the limit.
+static bool indices_below(const size_t *indices, size_t count, size_t limit) {
+    for (size_t index = 0; index < count; index++) {
+        if (indices[index] >= limit) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Tells whether the offsets of a CSR array run from 0 to target_count without decreasing,
+// and the targets are below limit.
+static bool offsets_valid(const size_t *offsets, size_t node_count, const size_t *targets, size_t target_count,
+                          size_t limit) {
+    if (offsets[0] != 0 || offsets[node_count] != target_count) {
+        return false;
+    }
+    for (size_t node = 0; node < node_count; node++) {
+        if (offsets[node] > offsets[node + 1]) {
+            return false;
+        }
+    }
+    return indices_below(targets, target_count, limit);
+}
+
+// Tells whether every field starts inside the text, which ends with '\0'.
+static bool fields_valid(const SnapshotFields *fields) {
+    size_t field_count = fields->row_count * fields->column_count;
+    if (field_count == 0) {
+        return true;
+    }
+    if (fields->text_size == 0 || fields->text[fields->text_size - 1] != '\0') {
+        return false;
+    }
+    for (size_t index = 0; index < field_count; index++) {
+        if (fields->offsets[index] >= fields->text_size) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Tells whether every string starts inside the pool, which ends with '\0', and every name
+// and street is one of them.
+static bool strings_valid(const ContainerTable *containers) {
+    const StringPool *strings = &containers->strings;
+    if (strings->count > 0 && (strings->size == 0 || strings->data[strings->size - 1] != '\0')) {
+        return false;
+    }
+    for (uint32_t id = 0; id < strings->count; id++) {
+        if (strings->offsets[id] >= strings->size) {
+            return false;
+        }
+    }
+    for (size_t row = 0; row < containers->count; row++) {
+        if (containers->name[row] >= strings->count || containers->street[row] >= strings->count) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Tells whether every row of the index is a container with the key as its ID. The capacity
+// must be a power of two with a free slot, which ends the probing for a missing ID.
+static bool index_valid(const IdIndex *index, const ContainerTable *containers) {
+    if (index->capacity == 0 || (index->capacity & (index->capacity - 1)) != 0) {
+        return false;
+    }
+    bool free_slot = false;
+    for (size_t slot = 0; slot < index->capacity; slot++) {
+        if (index->rows[slot] == ID_INDEX_NOT_FOUND) {
+            free_slot = true;
+        } else if (index->rows[slot] >= containers->count || containers->id[index->rows[slot]] != index->keys[slot]) {
+            return false;
+        }
+    }
+    return free_slot;
+}
+
+static bool containers_valid(const ContainerTable *containers) {
+    for (size_t row = 0; row < containers->count; row++) {
+        // A bool of the file may hold any byte.
+        if (containers->waste_type[row] >= WASTE_TYPE_COUNT
+            || *(const unsigned char *) &containers->is_public[row] > 1) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+ * Checks every index a section holds into another section, so that even a
+ * file with a consistent checksum but made up contents cannot make the
+ * tables read outside of the mapping. Values that are not indices, such as
+ * coordinates or distances, are not checked.
+ */
+static bool sections_valid(const SnapshotData *data, const struct snapshot_header *header) {
+    const ContainerTable *containers = &data->containers;
+    const StationTable *stations = &data->stations;
+    return containers_valid(containers) && strings_valid(containers) && index_valid(&data->index, containers)
+           && indices_below(data->paths.a_row, data->paths.count, containers->count)
+           && indices_below(data->paths.b_row, data->paths.count, containers->count)
+           && offsets_valid(data->container_graph.offsets, data->container_graph.node_count,
+                            data->container_graph.targets, header->container_edge_count, containers->count)
+           && offsets_valid(stations->container_offsets, stations->count, stations->containers, containers->count,
+                            containers->count)
+           && indices_below(stations->station_of, containers->count, stations->count)
+           && offsets_valid(stations->graph.offsets, stations->graph.node_count, stations->graph.targets,
+                            header->station_edge_count, stations->count)
+           && hierarchy_valid(&data->hierarchy, header->hierarchy_edge_count)
+           && fields_valid(&data->container_fields) && fields_valid(&data->path_fields);
+}
+
+/*
+ * Maps the snapshot open as fd and closes the descriptor.
+ *
+ * The header is checked before the sections are used, then the indices of
+ * the sections. The checksum of the sections reads the whole file, so it
+ * is only verified on request.
+ */
+static bool map_snapshot(int fd, const SnapshotSource sources[2], bool verify, SnapshotData *data,
+                         SnapshotMapping *mapping) {
+    struct stat status;
+    if (fstat(fd, &status) == -1 || !S_ISREG(status.st_mode)
+        || (uint64_t) status.st_size < sizeof(struct snapshot_header) || (uint64_t) status.st_size > SIZE_MAX) {
+        close(fd);
+        return false;
+    }
+
+    size_t size = (size_t) status.st_size;
+    void *address = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (address == MAP_FAILED) {
+        return false;
+    }
+
+    const struct snapshot_header *header = address;
+    const char *payload = (const char *) address + sizeof(*header);
+    if (!header_valid(header, size, sources)
+        || (verify && checksum_words(CHECKSUM_START, payload, size - sizeof(*header)) != header->payload_checksum)) {
+        munmap(address, size);
+        return false;
+    }
+
+    memset(data, 0, sizeof(*data));
+    const char *cursor = payload;
+#define MAP_SECTION(field, count) \
+    data->field = (void *) cursor; \
+    cursor += aligned((count) * sizeof(*data->field));
+    SNAPSHOT_SECTIONS(MAP_SECTION)
+#undef MAP_SECTION
+
+    data->containers.count = header->container_count;
+    data->containers.strings.size = header->string_bytes;
+    data->containers.strings.capacity = header->string_bytes;
+    data->containers.strings.count = (uint32_t) header->string_count;
+    data->containers.strings.offsets_capacity = (uint32_t) header->string_count;
+    data->index.capacity = header->index_capacity;
+    data->paths.count = header->path_count;
+    data->container_graph.node_count = header->container_count;
+    data->stations.count = header->station_count;
+    data->stations.graph.node_count = header->station_count;
+    data->hierarchy.node_count = header->station_count;
+    data->container_fields.row_count = header->container_count;
+    data->container_fields.column_count = SNAPSHOT_CONTAINER_COLUMNS;
+    data->container_fields.text_size = header->container_text_size;
+    data->path_fields.row_count = header->path_count;
+    data->path_fields.column_count = SNAPSHOT_PATH_COLUMNS;
+    data->path_fields.text_size = header->path_text_size;
+
+    if (!sections_valid(data, header)) {
+        munmap(address, size);
+        return false;
+    }
+
+    mapping->address = address;
+    mapping->size = size;
+    return true;
+}
+
+bool snapshot_file_map(const char *path, const SnapshotSource sources[2], bool verify, SnapshotData *data,
+                       SnapshotMapping *mapping) {
+    assert(path != NULL && sources != NULL && data != NULL && mapping != NULL);
+
+    memset(mapping, 0, sizeof(*mapping));
+    if (!platform_supported()) {
+        return false;
+    }
+
+    int fd = open(path, O_RDONLY);
+    return fd != -1 && map_snapshot(fd, sources, verify, data, mapping);
+}
+
+bool snapshot_shm_map(const char *name, const SnapshotSource sources[2], bool verify, SnapshotData *data,
+                      SnapshotMapping *mapping) {
+    assert(name != NULL && sources != NULL && data != NULL && mapping != NULL);
+
+    memset(mapping, 0, sizeof(*mapping));
+    if (!platform_supported()) {
+        return false;
+    }
+
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd == -1) {
+        return false;
+    }
+
+    // Anyone can create an object of the name, only one that just the user could have written is used.
+    struct stat status;
+    if (fstat(fd, &status) == -1 || status.st_uid != geteuid() || (status.st_mode & (S_IWGRP | S_IWOTH)) != 0) {
+        close(fd);
+        return false;
+    }
+    return map_snapshot(fd, sources, verify, data, mapping);
+}
+
+void snapshot_file_unmap(SnapshotMapping *mapping) {
+    assert(mapping != NULL);
+
+    if (mapping->address != NULL) {
+        munmap(mapping->address, mapping->size);
+    }
+    memset(mapping, 0, sizeof(*mapping));
+}
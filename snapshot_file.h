@@ -0,0 +1,90 @@
+#ifndef SNAPSHOT_FILE_H
+#define SNAPSHOT_FILE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "container.h"
+#include "graph.h"
+#include "hierarchy.h"
+#include "id_index.h"
+#include "path.h"
+#include "station.h"
+
+// Size and modification time of a CSV file a snapshot file was written from.
+typedef struct SnapshotSource {
+    uint64_t size;
+    int64_t modified_seconds;
+    int64_t modified_nanoseconds;
+} SnapshotSource;
+
+// Text fields of the rows of one CSV file, given either as lines[row][column] or as
+// offsets[row * column_count + column] into text, where every field ends with '\0'.
+typedef struct SnapshotFields {
+    size_t row_count;
+    size_t column_count;
+    char ***lines;
+    const uint64_t *offsets;
+    const char *text;
+    size_t text_size;
+} SnapshotFields;
+
+// Everything a snapshot file stores. Mapped tables point into the file and must not be
+// modified nor destroyed, snapshot_file_unmap() releases them all at once.
+typedef struct SnapshotData {
+    ContainerTable containers;
+    PathTable paths;
+    IdIndex index;
+    Graph container_graph;
+    StationTable stations;
+    // Contraction hierarchy of the station graph, so route queries need not contract it.
+    ContractionHierarchy hierarchy;
+    SnapshotFields container_fields;
+    SnapshotFields path_fields;
+} SnapshotData;
+
+// Mapping of a snapshot file.
+typedef struct SnapshotMapping {
+    void *address;
+    size_t size;
+} SnapshotMapping;
+
+// Reads the size and modification time of the file. Returns false if it cannot be accessed.
+bool snapshot_source_read(const char *path, SnapshotSource *source);
+
+// Writes the data to a snapshot file at the path, tagged with the sources of both CSV files.
+// The file is written under a temporary name and renamed over the path, so mappings of the
+// previous file stay valid. Returns false on I/O failure or on a platform the format does
+// not describe (a big-endian one, or one with size_t other than 64 bits).
+bool snapshot_file_write(const char *path, const SnapshotData *data, const SnapshotSource sources[2]);
+
+// Maps the snapshot file at the path and points the data into it. Returns false if the file
+// is missing, of another format version or platform, was written from CSV files of other
+// sizes or modification times than the sources, or any of its sections holds an index out
+// of range. With verify, the checksum of all the sections is checked as well, which reads
+// the whole file.
+//
+// Without verify, a damaged value that is not an index (a coordinate, a distance, ...) is
+// returned as it is, so callers that cannot trust the file should verify it; the command
+// line always does. The CSV files are matched by their size and modification time only:
+// hashing their contents would read them whole, which is what the snapshot saves.
+bool snapshot_file_map(const char *path, const SnapshotSource sources[2], bool verify, SnapshotData *data,
+                       SnapshotMapping *mapping);
+
+// Writes the data to the POSIX shared memory object of the name, the same way as to a
+// snapshot file. The object is private to the user. A previous object of the name is
+// replaced, processes that attached to it keep their mapping.
+bool snapshot_shm_write(const char *name, const SnapshotData *data, const SnapshotSource sources[2]);
+
+// Maps the shared memory object of the name read-only, same as snapshot_file_map(). An object
+// owned by another user, or one that other users may write to, is not used.
+bool snapshot_shm_map(const char *name, const SnapshotSource sources[2], bool verify, SnapshotData *data,
+                      SnapshotMapping *mapping);
+
+// Removes the shared memory object of the name. Returns false if there is none.
+bool snapshot_shm_remove(const char *name);
+
+// Unmaps the snapshot file, the data mapped from it can no longer be used.
+void snapshot_file_unmap(SnapshotMapping *mapping);
+
+#endif // SNAPSHOT_FILE_H
@@ -0,0 +1,161 @@
+#include "station.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define STATION_EMPTY_SLOT SIZE_MAX
+
+static uint64_t hash_coordinates(int64_t x_key, int64_t y_key) {
+    uint64_t hash = (uint64_t) x_key * 0x9e3779b97f4a7c15ULL ^ (uint64_t) y_key;
+    hash ^= hash >> 29;
+    hash *= 0xbf58476d1ce4e5b9ULL;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+bool station_assign(const ContainerTable *containers, size_t *station_of, size_t *station_count) {
+    assert(containers != NULL && station_of != NULL && station_count != NULL);
+
+    // Slot holds the first row of a station, the table is at most half full.
+    size_t capacity = 16;
+    while (capacity < containers->count * 2) {
+        capacity *= 2;
+    }
+    size_t *slots = malloc(capacity * sizeof(size_t));
+    if (slots == NULL) {
+        return false;
+    }
+    for (size_t slot = 0; slot < capacity; slot++) {
+        slots[slot] = STATION_EMPTY_SLOT;
+    }
+
+    *station_count = 0;
+    for (size_t row = 0; row < containers->count; row++) {
+        int64_t x_key = containers->x_key[row];
+        int64_t y_key = containers->y_key[row];
+        size_t slot = hash_coordinates(x_key, y_key) & (capacity - 1);
+
+        while (slots[slot] != STATION_EMPTY_SLOT
+               && (containers->x_key[slots[slot]] != x_key || containers->y_key[slots[slot]] != y_key)) {
+            slot = (slot + 1) & (capacity - 1);
+        }
+
+        if (slots[slot] == STATION_EMPTY_SLOT) {
+            slots[slot] = row;
+            station_of[row] = (*station_count)++;
+        } else {
+            station_of[row] = station_of[slots[slot]];
+        }
+    }
+
+    free(slots);
+    return true;
+}
+
+// Groups the container rows by station with a stable counting sort.
+static bool group_containers(StationTable *table, const ContainerTable *containers) {
+    table->container_offsets = calloc(table->count + 1, sizeof(size_t));
+    table->containers = malloc(containers->count * sizeof(size_t) + 1);
+    if (table->container_offsets == NULL || table->containers == NULL) {
+        return false;
+    }
+
+    for (size_t row = 0; row < containers->count; row++) {
+        table->container_offsets[table->station_of[row] + 1]++;
+    }
+    for (size_t station = 0; station < table->count; station++) {
+        table->container_offsets[station + 1] += table->container_offsets[station];
+    }
+
+    size_t *next = malloc(table->count * sizeof(size_t) + 1);
+    if (next == NULL) {
+        return false;
+    }
+    memcpy(next, table->container_offsets, table->count * sizeof(size_t));
+    for (size_t row = 0; row < containers->count; row++) {
+        table->containers[next[table->station_of[row]]++] = row;
+    }
+
+    free(next);
+    return true;
+}
+
+/*
+ * Projects every path between containers of different stations onto the
+ * stations. graph_build drops the paths inside a station, keeps the shortest
+ * of repeated station pairs and sorts the neighbors by station.
+ */
+static bool build_station_graph(StationTable *table, const Graph *container_graph) {
+    size_t arc_count = container_graph->offsets[container_graph->node_count];
+    size_t *a = malloc(arc_count * sizeof(size_t) + 1);
+    size_t *b = malloc(arc_count * sizeof(size_t) + 1);
+    uint32_t *weights = malloc(arc_count * sizeof(uint32_t) + 1);
+    if (a == NULL || b == NULL || weights == NULL) {
+        free(a);
+        free(b);
+        free(weights);
+        return false;
+    }
+
+    // Every path is in the container graph in both directions, one is enough.
+    size_t edge_count = 0;
+    for (size_t row = 0; row < container_graph->node_count; row++) {
+        for (size_t k = container_graph->offsets[row]; k < container_graph->offsets[row + 1]; k++) {
+            if (row < container_graph->targets[k]) {
+                a[edge_count] = table->station_of[row];
+                b[edge_count] = table->station_of[container_graph->targets[k]];
+                weights[edge_count] = container_graph->weights[k];
+                edge_count++;
+            }
+        }
+    }
+
+    GraphEdges edges = { edge_count, a, b, weights };
+    bool built = graph_build(&table->graph, table->count, &edges, NULL);
+
+    free(a);
+    free(b);
+    free(weights);
+    return built;
+}
+
+bool station_table_build(StationTable *table, const ContainerTable *containers, const Graph *container_graph) {
+    assert(table != NULL && containers != NULL && container_graph != NULL);
+    assert(container_graph->node_count == containers->count);
+
+    memset(table, 0, sizeof(*table));
+    table->station_of = malloc(containers->count * sizeof(size_t) + 1);
+    if (table->station_of == NULL || !station_assign(containers, table->station_of, &table->count)) {
+        station_table_destroy(table);
+        return false;
+    }
+
+    table->waste_types = calloc(table->count + 1, sizeof(WasteTypeMask));
+    table->capacity = calloc(table->count + 1, sizeof(*table->capacity));
+    if (table->waste_types == NULL || table->capacity == NULL || !group_containers(table, containers)
+        || !build_station_graph(table, container_graph)) {
+        station_table_destroy(table);
+        return false;
+    }
+
+    for (size_t row = 0; row < containers->count; row++) {
+        size_t station = table->station_of[row];
+        table->waste_types[station] |= WASTE_TYPE_MASK(containers->waste_type[row]);
+        table->capacity[station][containers->waste_type[row]] += containers->capacity[row];
+    }
+
+    return true;
+}
+
+void station_table_destroy(StationTable *table) {
+    assert(table != NULL);
+
+    free(table->waste_types);
+    free(table->capacity);
+    free(table->container_offsets);
+    free(table->containers);
+    free(table->station_of);
+    graph_destroy(&table->graph);
+    memset(table, 0, sizeof(*table));
+}
@@ -0,0 +1,38 @@
+#ifndef STATION_H
+#define STATION_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "container.h"
+#include "graph.h"
+#include "waste_type.h"
+
+// Groups containers into stations. Containers with coordinates equal to COORDINATE_DECIMALS
+// decimal places share a station, stations are numbered from 0 in the order of their first
+// container. station_of[row] receives the station of every row. Returns false on allocation failure.
+bool station_assign(const ContainerTable *containers, size_t *station_of, size_t *station_count);
+
+// Stations stored column by column. The container rows of station s are
+// containers[container_offsets[s]] up to containers[container_offsets[s + 1] - 1] in the
+// order of the file, capacity[s][type] is the total capacity of its containers of the type.
+// Two stations are neighbors when a path connects their containers, the graph keeps the
+// shortest such path between them and lists the neighbors of every station in station order.
+typedef struct StationTable {
+    size_t count;
+    WasteTypeMask *waste_types;
+    uint64_t (*capacity)[WASTE_TYPE_COUNT];
+    size_t *container_offsets;
+    size_t *containers;
+    size_t *station_of;
+    Graph graph;
+} StationTable;
+
+// Builds the stations of the containers and projects the graph of containers onto them.
+// Returns false on allocation failure.
+bool station_table_build(StationTable *table, const ContainerTable *containers, const Graph *container_graph);
+
+// Frees the memory of the table.
+void station_table_destroy(StationTable *table);
+
+#endif // STATION_H
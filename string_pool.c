@@ -0,0 +1,116 @@
+#include "string_pool.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define STRING_POOL_EMPTY_SLOT UINT32_MAX
+
+static uint64_t hash_string(const char *str) {
+    // FNV-1a
+    uint64_t hash = 14695981039346656037ULL;
+    for (; *str != '\0'; str++) {
+        hash ^= (unsigned char) *str;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+static size_t find_slot(const StringPool *pool, const char *str) {
+    size_t mask = pool->slot_count - 1;
+    size_t slot = hash_string(str) & mask;
+
+    while (pool->slots[slot] != STRING_POOL_EMPTY_SLOT
+           && strcmp(pool->data + pool->offsets[pool->slots[slot]], str) != 0) {
+        slot = (slot + 1) & mask;
+    }
+
+    return slot;
+}
+
+static bool grow_slots(StringPool *pool) {
+    size_t slot_count = pool->slot_count == 0 ? 64 : pool->slot_count * 2;
+    uint32_t *slots = malloc(slot_count * sizeof(uint32_t));
+    if (slots == NULL) {
+        return false;
+    }
+    memset(slots, 0xff, slot_count * sizeof(uint32_t));
+
+    free(pool->slots);
+    pool->slots = slots;
+    pool->slot_count = slot_count;
+
+    for (uint32_t id = 0; id < pool->count; id++) {
+        pool->slots[find_slot(pool, pool->data + pool->offsets[id])] = id;
+    }
+
+    return true;
+}
+
+void string_pool_init(StringPool *pool) {
+    assert(pool != NULL);
+
+    memset(pool, 0, sizeof(*pool));
+}
+
+uint32_t string_pool_intern(StringPool *pool, const char *str) {
+    assert(pool != NULL && str != NULL);
+
+    // Keep the table at most half full.
+    if ((size_t) pool->count * 2 >= pool->slot_count && !grow_slots(pool)) {
+        return STRING_POOL_ERROR;
+    }
+
+    size_t slot = find_slot(pool, str);
+    if (pool->slots[slot] != STRING_POOL_EMPTY_SLOT) {
+        return pool->slots[slot];
+    }
+
+    size_t length = strlen(str) + 1;
+    if (pool->count == STRING_POOL_ERROR || pool->size + length > UINT32_MAX) {
+        return STRING_POOL_ERROR;
+    }
+
+    if (pool->size + length > pool->capacity) {
+        size_t capacity = pool->capacity * 2 + length;
+        char *data = realloc(pool->data, capacity);
+        if (data == NULL) {
+            return STRING_POOL_ERROR;
+        }
+        pool->data = data;
+        pool->capacity = capacity;
+    }
+
+    if (pool->count == pool->offsets_capacity) {
+        uint32_t capacity = pool->offsets_capacity * 2 + 16;
+        uint32_t *offsets = realloc(pool->offsets, capacity * sizeof(uint32_t));
+        if (offsets == NULL) {
+            return STRING_POOL_ERROR;
+        }
+        pool->offsets = offsets;
+        pool->offsets_capacity = capacity;
+    }
+
+    memcpy(pool->data + pool->size, str, length);
+    pool->offsets[pool->count] = (uint32_t) pool->size;
+    pool->size += length;
+    pool->slots[slot] = pool->count;
+
+    return pool->count++;
+}
+
+const char *string_pool_get(const StringPool *pool, uint32_t id) {
+    assert(pool != NULL && id < pool->count);
+
+    return pool->data + pool->offsets[id];
+}
+
+void string_pool_destroy(StringPool *pool) {
+    assert(pool != NULL);
+
+    free(pool->data);
+    free(pool->offsets);
+    free(pool->slots);
+    string_pool_init(pool);
+}
@@ -0,0 +1,37 @@
+#ifndef STRING_POOL_H
+#define STRING_POOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define STRING_POOL_ERROR UINT32_MAX
+
+// Interns strings: equal strings share one copy and one ID. Strings are stored
+// back to back and referenced by offsets, so the pool can be copied as is.
+typedef struct StringPool {
+    char *data;
+    size_t size;
+    size_t capacity;
+
+    uint32_t *offsets;
+    uint32_t count;
+    uint32_t offsets_capacity;
+
+    uint32_t *slots;
+    size_t slot_count;
+} StringPool;
+
+// Prepares an empty pool.
+void string_pool_init(StringPool *pool);
+
+// Returns the ID of the string, adding it to the pool if needed, or STRING_POOL_ERROR
+// on allocation failure.
+uint32_t string_pool_intern(StringPool *pool, const char *str);
+
+// Returns the string with the given ID.
+const char *string_pool_get(const StringPool *pool, uint32_t id);
+
+// Frees the memory of the pool.
+void string_pool_destroy(StringPool *pool);
+
+#endif // STRING_POOL_H
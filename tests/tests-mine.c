@@ -2,31 +2,451 @@
  * You can use this file for your own tests
  */
 
+#define _POSIX_C_SOURCE 200809L
+
 #include "libs/cut.h"
 #include "libs/mainwrap.h"
 #include "libs/utils.h"
 
 #include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../data_source.h"
+#include "../parse_args.h"
 
 /* The following “extentions” to CUT are available in this test file:
  *
- * • ‹CHECK_IS_EMPTY(file)› — test whether the file is empty.
+ * • ‹CHECK_IS_EMPTY(file)› — test whether the file is empty.
  * • ‹CHECK_NOT_EMPTY(file)› — inverse of the above.
  *
  * • ‹app_main_args(ARG…)› — call your ‹main()› with given arguments.
  * • ‹app_main()› — call your ‹main()› without any arguments. */
 
-TEST(my_test)
+#define CONTAINERS_FILE "tests/data/example-containers.csv"
+#define DUPLICATE_PATHS_FILE "tests/data/example-paths-duplicates.csv"
+
+/* Paths repeated or listed in both directions count once */
+TEST(duplicate_paths)
+{
+    CHECK(app_main_args(CONTAINERS_FILE, DUPLICATE_PATHS_FILE) == 0);
+
+    const char *correct_output =
+        "ID: 1, Type: Colored glass, Capacity: 1550, Address: Drozdi 55, Neighbors: 4\n"
+        "ID: 2, Type: Clear glass, Capacity: 1550, Address: Drozdi 55, Neighbors: 4\n"
+        "ID: 3, Type: Plastics and Aluminium, Capacity: 1100, Address: Drozdi 55, Neighbors: 4\n"
+        "ID: 4, Type: Colored glass, Capacity: 900, Address: Drozdi 55, Neighbors: 1 2 3 5 8\n"
+        "ID: 5, Type: Paper, Capacity: 5000, Address: Klimesova 60, Neighbors: 4 8\n"
+        "ID: 6, Type: Colored glass, Capacity: 3000, Address: Klimesova 60, Neighbors: 8\n"
+        "ID: 7, Type: Plastics and Aluminium, Capacity: 5000, Address: Klimesova 60, Neighbors: 8\n"
+        "ID: 8, Type: Biodegradable waste, Capacity: 3000, Address: Na Buble 5, Neighbors: 4 5 6 7 11\n"
+        "ID: 9, Type: Textile, Capacity: 500, Address: Na Buble 5, Neighbors: 10\n"
+        "ID: 10, Type: Plastics and Aluminium, Capacity: 900, Address: Odlehla 70, Neighbors: 9\n"
+        "ID: 11, Type: Paper, Capacity: 2000, Address: Odlehla 70, Neighbors: 8\n"
+    ;
+
+    ASSERT_FILE(stdout, correct_output);
+    CHECK_IS_EMPTY(stderr);
+}
+
+#define PATHS_FILE "tests/data/example-paths.csv"
+
+/* Every priority queue finds the route from the assignment */
+TEST(route_priority_queues)
+{
+    SUBTEST(binary) {
+        CHECK(app_main_args("-g", "1,5", "-q", "binary", CONTAINERS_FILE, PATHS_FILE) == 0);
+        ASSERT_FILE(stdout, "1-2-3-4-5 1300\n");
+        CHECK_IS_EMPTY(stderr);
+    }
+    SUBTEST(pairing) {
+        CHECK(app_main_args("-g", "1,5", "-q", "pairing", CONTAINERS_FILE, PATHS_FILE) == 0);
+        ASSERT_FILE(stdout, "1-2-3-4-5 1300\n");
+        CHECK_IS_EMPTY(stderr);
+    }
+    SUBTEST(radix) {
+        CHECK(app_main_args("-g", "1,5", "-q", "radix", CONTAINERS_FILE, PATHS_FILE) == 0);
+        ASSERT_FILE(stdout, "1-2-3-4-5 1300\n");
+        CHECK_IS_EMPTY(stderr);
+    }
+}
+
+/* Searching from both ends finds the same route in both directions */
+TEST(route_bidirectional)
+{
+    SUBTEST(forward) {
+        CHECK(app_main_args("-g", "1,5", "-a", "bidirectional", CONTAINERS_FILE, PATHS_FILE) == 0);
+        ASSERT_FILE(stdout, "1-2-3-4-5 1300\n");
+        CHECK_IS_EMPTY(stderr);
+    }
+    SUBTEST(backward) {
+        CHECK(app_main_args("-g", "5,1", "-a", "bidirectional", CONTAINERS_FILE, PATHS_FILE) == 0);
+        ASSERT_FILE(stdout, "5-4-3-2-1 1300\n");
+        CHECK_IS_EMPTY(stderr);
+    }
+}
+
+/* The contraction hierarchy unpacks its shortcuts into the full route, built for one route it warns */
+TEST(route_contraction_hierarchy)
+{
+    CHECK(app_main_args("-g", "1,5", "-a", "ch", CONTAINERS_FILE, PATHS_FILE) == 0);
+    ASSERT_FILE(stdout, "1-2-3-4-5 1300\n");
+    ASSERT_FILE(stderr, "Contracting the stations for a single route, use -S or -P to keep the hierarchy\n");
+}
+
+/* A* with landmark bounds finds the shortest route */
+TEST(route_landmarks)
 {
-    int rv = 0; /* return value of main()*/
-    CHECK(app_main_args("FILE" /*, arguments for main() */) == rv);
+    CHECK(app_main_args("-g", "5,1", "-a", "alt", CONTAINERS_FILE, PATHS_FILE) == 0);
+    ASSERT_FILE(stdout, "5-4-3-2-1 1300\n");
+    CHECK_IS_EMPTY(stderr);
+}
+
+/* A route from a station to itself is empty */
+TEST(route_same_station)
+{
+    CHECK(app_main_args("-g", "3,3", CONTAINERS_FILE, PATHS_FILE) == 0);
+    ASSERT_FILE(stdout, "3 0\n");
+    CHECK_IS_EMPTY(stderr);
+}
+
+/* Station IDs beyond the last station are rejected */
+TEST(route_unknown_station)
+{
+    CHECK(app_main_args("-g", "1,6", CONTAINERS_FILE, PATHS_FILE) != 0);
+    CHECK_NOT_EMPTY(stderr);
+}
 
-    /* TIP: Use ‹app_main()› to test the program without arguments. */
+#define BATCH_FILE "tests/data/example-batch.txt"
+
+/* Batch commands share one load and each result ends with an empty line */
+TEST(batch_commands)
+{
+    CHECK(app_main_args("-b", BATCH_FILE, CONTAINERS_FILE, PATHS_FILE) == 0);
 
     const char *correct_output =
-        "Output on STDOUT"
+        "1-2-3-4-5 1300\n"
+        "\n"
+        "ID: 3, Type: Plastics and Aluminium, Capacity: 1100, Address: Drozdi 55, Neighbors: 4\n"
+        "\n"
+        "1;AGC;2\n"
+        "2;C;1,3,4\n"
+        "3;APC;2,4\n"
+        "4;BT;2,3,5\n"
+        "5;AP;4\n"
+        "\n"
+        "5-4-3-2-1 1300\n"
+        "\n"
+        "ID: 5, Type: Paper, Capacity: 5000, Address: Klimesova 60, Neighbors: 4 8\n"
+        "ID: 6, Type: Colored glass, Capacity: 3000, Address: Klimesova 60, Neighbors: 8\n"
+        "ID: 7, Type: Plastics and Aluminium, Capacity: 5000, Address: Klimesova 60, Neighbors: 8\n"
+        "\n"
     ;
 
     ASSERT_FILE(stdout, correct_output);
-    CHECK_FILE(stderr, "" /* STDERR is empty*/);
+    CHECK_IS_EMPTY(stderr);
+}
+
+/* Data sources opened at once keep their own data */
+TEST(data_source_handles)
+{
+    DataSource *example = data_source_open(CONTAINERS_FILE, PATHS_FILE);
+    DataSource *duplicates = data_source_open(CONTAINERS_FILE, DUPLICATE_PATHS_FILE);
+    ASSERT(example != NULL && duplicates != NULL);
+
+    CHECK(data_source_path_table(example)->count == 11);
+    CHECK(data_source_path_table(duplicates)->count > 11);
+    CHECK(strcmp(data_source_path_distance(example, 0), "500") == 0);
+    CHECK(data_source_path_distance(example, 11) == NULL);
+    CHECK(data_source_version(example) == 1);
+
+    data_source_close(duplicates);
+    CHECK(strcmp(data_source_container_id(example, 10), "11") == 0);
+    data_source_close(example);
+}
+
+#define TEMP_FILE_TEMPLATE "/tmp/garbage-container-XXXXXX"
+
+/* Creates an empty file of a unique name in place of the template, so tests running at once do not share it */
+static void make_temp_file(char *path)
+{
+    int fd = mkstemp(path);
+    ASSERT(fd != -1);
+    close(fd);
+}
+
+/* A snapshot file serves the same data without loading the input files */
+TEST(snapshot_file)
+{
+    char snapshot_file[] = TEMP_FILE_TEMPLATE;
+    make_temp_file(snapshot_file);
+    DataSource *loaded = data_source_open_snapshot(CONTAINERS_FILE, PATHS_FILE, snapshot_file);
+    ASSERT(loaded != NULL);
+    CHECK(!data_source_snapshot_mapped(loaded));
+    ASSERT(data_source_write_snapshot(loaded, snapshot_file));
+
+    DataSource *mapped = data_source_open_snapshot(CONTAINERS_FILE, PATHS_FILE, snapshot_file);
+    ASSERT(mapped != NULL);
+    CHECK(data_source_snapshot_mapped(mapped));
+    CHECK(data_source_container_table(mapped)->count == data_source_container_table(loaded)->count);
+    CHECK(data_source_station_table(mapped)->count == data_source_station_table(loaded)->count);
+    CHECK(strcmp(data_source_container_name(mapped, 10), data_source_container_name(loaded, 10)) == 0);
+    CHECK(strcmp(data_source_path_distance(mapped, 0), "500") == 0);
+    CHECK(data_source_path_distance(mapped, 11) == NULL);
+
+    /* Snapshot files of other input files are not used */
+    DataSource *other = data_source_open_snapshot(CONTAINERS_FILE, DUPLICATE_PATHS_FILE, snapshot_file);
+    ASSERT(other != NULL);
+    CHECK(!data_source_snapshot_mapped(other));
+
+    data_source_close(other);
+    data_source_close(mapped);
+    data_source_close(loaded);
+    remove(snapshot_file);
+}
+
+/* Routes through a snapshot file use the contraction hierarchy saved in it */
+TEST(snapshot_file_hierarchy)
+{
+    char snapshot_file[] = TEMP_FILE_TEMPLATE;
+    make_temp_file(snapshot_file);
+    CHECK(app_main_args("-g", "1,5", "-a", "ch", "-S", snapshot_file, CONTAINERS_FILE, PATHS_FILE) == 0);
+    CHECK(app_main_args("-g", "5,1", "-a", "ch", "-S", snapshot_file, CONTAINERS_FILE, PATHS_FILE) == 0);
+
+    DataSource *mapped = data_source_open_snapshot(CONTAINERS_FILE, PATHS_FILE, snapshot_file);
+    ASSERT(mapped != NULL);
+    CHECK(data_source_snapshot_mapped(mapped));
+    CHECK(data_source_station_hierarchy(mapped)->node_count == 5);
+    data_source_close(mapped);
+    remove(snapshot_file);
+
+    ASSERT_FILE(stdout, "1-2-3-4-5 1300\n5-4-3-2-1 1300\n");
+    CHECK_IS_EMPTY(stderr);
+}
+
+/* A snapshot file holding indices out of range is not used even if its header is fine */
+TEST(snapshot_file_corrupt)
+{
+    char snapshot_file[] = TEMP_FILE_TEMPLATE;
+    make_temp_file(snapshot_file);
+    DataSource *loaded = data_source_open_snapshot(CONTAINERS_FILE, PATHS_FILE, snapshot_file);
+    ASSERT(loaded != NULL);
+    ASSERT(data_source_write_snapshot(loaded, snapshot_file));
+
+    /* Overwrites the second half of the file, keeping its size and the header */
+    FILE *file = fopen(snapshot_file, "r+b");
+    ASSERT(file != NULL);
+    ASSERT(fseek(file, 0, SEEK_END) == 0);
+    long size = ftell(file);
+    ASSERT(fseek(file, size / 2, SEEK_SET) == 0);
+    for (long offset = size / 2; offset < size; offset++) {
+        fputc(0xff, file);
+    }
+    fclose(file);
+
+    DataSource *reloaded = data_source_open_snapshot(CONTAINERS_FILE, PATHS_FILE, snapshot_file);
+    ASSERT(reloaded != NULL);
+    CHECK(!data_source_snapshot_mapped(reloaded));
+    CHECK(strcmp(data_source_path_distance(reloaded, 0), "500") == 0);
+
+    data_source_close(reloaded);
+    data_source_close(loaded);
+    remove(snapshot_file);
+}
+
+/* A snapshot file with any byte changed is not used by the command line */
+TEST(snapshot_file_checksum)
+{
+    char snapshot_file[] = TEMP_FILE_TEMPLATE;
+    make_temp_file(snapshot_file);
+    CHECK(app_main_args("-g", "1,5", "-S", snapshot_file, CONTAINERS_FILE, PATHS_FILE) == 0);
+
+    /* Flips a bit in the middle of the file, keeping its size and the header */
+    FILE *file = fopen(snapshot_file, "r+b");
+    ASSERT(file != NULL);
+    ASSERT(fseek(file, 0, SEEK_END) == 0);
+    long size = ftell(file);
+    ASSERT(fseek(file, size / 2, SEEK_SET) == 0);
+    int byte = fgetc(file);
+    ASSERT(byte != EOF && fseek(file, size / 2, SEEK_SET) == 0);
+    fputc(byte ^ 1, file);
+    fclose(file);
+
+    DataSourceOptions options = { snapshot_file, NULL, CONTAINER_COLUMNS_ALL, false, true };
+    DataSource *verified = data_source_open_with(CONTAINERS_FILE, PATHS_FILE, &options);
+    ASSERT(verified != NULL);
+    CHECK(!data_source_snapshot_mapped(verified));
+    data_source_close(verified);
+
+    CHECK(app_main_args("-g", "1,5", "-S", snapshot_file, CONTAINERS_FILE, PATHS_FILE) == 0);
+    remove(snapshot_file);
+
+    ASSERT_FILE(stdout, "1-2-3-4-5 1300\n1-2-3-4-5 1300\n");
+    CHECK_IS_EMPTY(stderr);
+}
+
+/* Data published to shared memory is mapped by every later open of the same files */
+TEST(shared_memory)
+{
+    DataSource *loaded = data_source_open(CONTAINERS_FILE, PATHS_FILE);
+    ASSERT(loaded != NULL);
+    data_source_remove_shared(loaded);
+    ASSERT(data_source_publish_shared(loaded));
+
+    DataSource *mapped = data_source_open(CONTAINERS_FILE, PATHS_FILE);
+    ASSERT(mapped != NULL);
+    CHECK(data_source_snapshot_mapped(mapped));
+    CHECK(data_source_path_table(mapped)->count == 11);
+    CHECK(strcmp(data_source_container_id(mapped, 10), "11") == 0);
+
+    /* -R removes it without loading the files */
+    CHECK(app_main_args("-R", CONTAINERS_FILE, PATHS_FILE) == 0);
+    CHECK(!data_source_remove_shared(loaded));
+    DataSource *reloaded = data_source_open(CONTAINERS_FILE, PATHS_FILE);
+    ASSERT(reloaded != NULL);
+    CHECK(!data_source_snapshot_mapped(reloaded));
+    CHECK_IS_EMPTY(stdout);
+    CHECK_IS_EMPTY(stderr);
+
+    data_source_close(reloaded);
+    data_source_close(mapped);
+    data_source_close(loaded);
+}
+
+/* Streaming reads the containers row by row and lists the same */
+TEST(stream_containers)
+{
+    CHECK(app_main_args("-m", "-t", "PA", "-c", "1000-2000", CONTAINERS_FILE, DUPLICATE_PATHS_FILE) == 0);
+
+    const char *correct_output =
+        "ID: 3, Type: Plastics and Aluminium, Capacity: 1100, Address: Drozdi 55, Neighbors: 4\n"
+        "ID: 11, Type: Paper, Capacity: 2000, Address: Odlehla 70, Neighbors: 8\n"
+    ;
+
+    ASSERT_FILE(stdout, correct_output);
+    CHECK_IS_EMPTY(stderr);
+}
+
+/* Filters given to the loader skip the strings of the other containers only */
+TEST(filtered_load)
+{
+    char snapshot_file[] = TEMP_FILE_TEMPLATE;
+    make_temp_file(snapshot_file);
+    Filters filters = default_filters();
+    filters.waste_types = WASTE_TYPE_MASK(WASTE_PAPER);
+    DataSourceOptions options = { NULL, &filters, CONTAINER_COLUMNS_ALL, false, false };
+    DataSource *source = data_source_open_with(CONTAINERS_FILE, PATHS_FILE, &options);
+    ASSERT(source != NULL);
+
+    CHECK(data_source_container_table(source)->street[4] != CONTAINER_NO_STRING);
+    CHECK(data_source_container_table(source)->street[0] == CONTAINER_NO_STRING);
+    CHECK(!data_source_write_snapshot(source, snapshot_file));
+    remove(snapshot_file);
+
+    filters.waste_types = WASTE_TYPE_MASK(WASTE_TEXTILE) | WASTE_TYPE_MASK(WASTE_PAPER);
+    data_source_print_containers(source, filters, stdout);
+    data_source_close(source);
+
+    const char *correct_output =
+        "ID: 5, Type: Paper, Capacity: 5000, Address: Klimesova 60, Neighbors: 4 8\n"
+        "ID: 9, Type: Textile, Capacity: 500, Address: Na Buble 5, Neighbors: 10\n"
+        "ID: 11, Type: Paper, Capacity: 2000, Address: Odlehla 70, Neighbors: 8\n"
+    ;
+
+    ASSERT_FILE(stdout, correct_output);
+    CHECK_IS_EMPTY(stderr);
+}
+
+/* Columns left out of the mask are validated but not stored */
+TEST(projected_columns)
+{
+    char snapshot_file[] = TEMP_FILE_TEMPLATE;
+    make_temp_file(snapshot_file);
+    DataSourceOptions options = { NULL, NULL, DATA_SOURCE_STATION_COLUMNS, false, false };
+    DataSource *stations = data_source_open_with(CONTAINERS_FILE, PATHS_FILE, &options);
+    options.columns = DATA_SOURCE_LISTING_COLUMNS;
+    DataSource *listing = data_source_open_with(CONTAINERS_FILE, PATHS_FILE, &options);
+    ASSERT(stations != NULL && listing != NULL);
+
+    CHECK(data_source_station_table(stations)->count == 5);
+    CHECK(data_source_container_table(stations)->street[0] == CONTAINER_NO_STRING);
+    CHECK(data_source_station_table(listing)->count == 0);
+    CHECK(data_source_container_table(listing)->street[0] != CONTAINER_NO_STRING);
+    CHECK(!data_source_write_snapshot(listing, snapshot_file));
+
+    data_source_close(listing);
+    data_source_close(stations);
+    remove(snapshot_file);
+}
+
+/* A lazy data source splits only the rows whose fields are used */
+TEST(lazy_fields)
+{
+    DataSourceOptions options = { NULL, NULL, CONTAINER_COLUMNS_ALL, true, false };
+    DataSource *source = data_source_open_with(CONTAINERS_FILE, PATHS_FILE, &options);
+    ASSERT(source != NULL);
+
+    size_t line_index = 0;
+    CHECK(data_source_find_container(source, 11, &line_index));
+    CHECK(line_index == 10);
+    CHECK(!data_source_find_container(source, 12, &line_index));
+    CHECK(strcmp(data_source_container_street(source, 10), "Odlehla") == 0);
+    CHECK(strcmp(data_source_container_id(source, 10), "11") == 0);
+    CHECK(data_source_container_id(source, 11) == NULL);
+    CHECK(strcmp(data_source_path_distance(source, 0), "500") == 0);
+
+    /* The tables are built once a query needs them */
+    CHECK(data_source_station_table(source)->count == 5);
+    CHECK(data_source_container_table(source)->count == 11);
+    CHECK(strcmp(data_source_container_street(source, 10), "Odlehla") == 0);
+
+    data_source_close(source);
+}
+
+/* The get_* functions split the rows of a lazily initialized data source on first use */
+TEST(lazy_default_source)
+{
+    ASSERT(init_data_source_lazy(CONTAINERS_FILE, PATHS_FILE));
+
+    size_t line_index = 0;
+    CHECK(find_container_by_id(5, &line_index));
+    CHECK(line_index == 4);
+    CHECK(strcmp(get_container_street(4), "Klimesova") == 0);
+    CHECK(strcmp(get_path_b_id(1), "4") == 0);
+    CHECK(print_stations(stdout));
+
+    destroy_data_source();
+    ASSERT_FILE(stdout, "1;AGC;2\n2;C;1,3,4\n3;APC;2,4\n4;BT;2,3,5\n5;AP;4\n");
+}
+
+/* A lazy data source finds no container of a repeated ID or an invalid row, and lists none of them */
+TEST(lazy_fields_invalid)
+{
+    char containers_file[] = TEMP_FILE_TEMPLATE;
+    make_temp_file(containers_file);
+    FILE *file = fopen(containers_file, "w");
+    ASSERT(file != NULL);
+    fputs("1,16.6,49.2,Colored glass,1550,Drozdi - SMO,Drozdi,55,Y\n"
+          "1,16.6,49.2,Clear glass,1550,Drozdi - SMO,Drozdi,55,Y\n"
+          "2,16.6,49.2\n"
+          "3,16.6,49.2,Plastics and Aluminium,1100,Drozdi - SMO,Drozdi,55,Y\n", file);
+    fclose(file);
+
+    DataSourceOptions options = { NULL, NULL, CONTAINER_COLUMNS_ALL, true, false };
+    DataSource *source = data_source_open_with(containers_file, PATHS_FILE, &options);
+    ASSERT(source != NULL);
+
+    size_t line_index = 0;
+    CHECK(!data_source_find_container(source, 1, &line_index));
+    CHECK(!data_source_find_container(source, 2, &line_index));
+    CHECK(data_source_container_id(source, 2) == NULL);
+    CHECK(data_source_find_container(source, 3, &line_index));
+    CHECK(line_index == 3);
+    CHECK(strcmp(data_source_container_name(source, 3), "Drozdi - SMO") == 0);
+    CHECK(!data_source_print_containers(source, default_filters(), stdout));
+    CHECK(data_source_container_table(source)->count == 0);
+
+    data_source_close(source);
+    remove(containers_file);
+    CHECK_IS_EMPTY(stdout);
 }
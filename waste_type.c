@@ -0,0 +1,63 @@
+#include "waste_type.h"
+
+#include <assert.h>
+#include <string.h>
+
+static const struct {
+    char letter;
+    const char *name;
+} waste_types[WASTE_TYPE_COUNT] = {
+    [WASTE_PLASTICS_AND_ALUMINIUM] = { 'A', "Plastics and Aluminium" },
+    [WASTE_PAPER] = { 'P', "Paper" },
+    [WASTE_BIODEGRADABLE] = { 'B', "Biodegradable waste" },
+    [WASTE_CLEAR_GLASS] = { 'G', "Clear glass" },
+    [WASTE_COLORED_GLASS] = { 'C', "Colored glass" },
+    [WASTE_TEXTILE] = { 'T', "Textile" },
+};
+
+bool waste_type_parse(const char *name, WasteType *type) {
+    assert(name != NULL && type != NULL);
+
+    for (int index = 0; index < WASTE_TYPE_COUNT; index++) {
+        if (strcmp(name, waste_types[index].name) == 0) {
+            *type = (WasteType) index;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool waste_type_from_letter(char letter, WasteType *type) {
+    assert(type != NULL);
+
+    for (int index = 0; index < WASTE_TYPE_COUNT; index++) {
+        if (letter == waste_types[index].letter) {
+            *type = (WasteType) index;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char *waste_type_name(WasteType type) {
+    assert(type < WASTE_TYPE_COUNT);
+
+    return waste_types[type].name;
+}
+
+char waste_type_letter(WasteType type) {
+    assert(type < WASTE_TYPE_COUNT);
+
+    return waste_types[type].letter;
+}
+
+void waste_type_mask_letters(WasteTypeMask mask, char *buffer) {
+    assert(buffer != NULL);
+
+    for (int index = 0; index < WASTE_TYPE_COUNT; index++) {
+        if (mask & WASTE_TYPE_MASK(index)) {
+            *buffer++ = waste_types[index].letter;
+        }
+    }
+    *buffer = '\0';
+}
@@ -0,0 +1,40 @@
+#ifndef WASTE_TYPE_H
+#define WASTE_TYPE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Waste types in the order of the assignment, which is also the order of their letters in outputs.
+typedef enum WasteType {
+    WASTE_PLASTICS_AND_ALUMINIUM,
+    WASTE_PAPER,
+    WASTE_BIODEGRADABLE,
+    WASTE_CLEAR_GLASS,
+    WASTE_COLORED_GLASS,
+    WASTE_TEXTILE,
+    WASTE_TYPE_COUNT
+} WasteType;
+
+// Set of waste types, bit i stands for the WasteType i.
+typedef uint8_t WasteTypeMask;
+
+#define WASTE_TYPE_MASK(type) ((WasteTypeMask) (1u << (type)))
+#define WASTE_TYPE_MASK_ALL ((WasteTypeMask) ((1u << WASTE_TYPE_COUNT) - 1))
+
+// Finds the waste type with the full name, e.g. "Paper". Returns false for an unknown name.
+bool waste_type_parse(const char *name, WasteType *type);
+
+// Finds the waste type with the letter used by the -t filter, e.g. 'P'. Returns false for an unknown letter.
+bool waste_type_from_letter(char letter, WasteType *type);
+
+// Returns the full name of the waste type.
+const char *waste_type_name(WasteType type);
+
+// Returns the letter of the waste type.
+char waste_type_letter(WasteType type);
+
+// Writes the letters of the types in the mask to buffer in the order of the assignment.
+// The buffer needs room for WASTE_TYPE_COUNT letters and '\0'.
+void waste_type_mask_letters(WasteTypeMask mask, char *buffer);
+
+#endif // WASTE_TYPE_H